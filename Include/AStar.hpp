@@ -39,6 +39,26 @@
 #include <vector>
 #include <queue>
 #include <cfloat>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "ConnectedComponents.hpp"
+#include "StateIndex.hpp"
+
+// Define ASTAR_TRACE to let a SearchTrace record every event of the search,
+// without it the hooks cost nothing
+#ifdef ASTAR_TRACE
+#include "SearchTrace.hpp"
+
+#define ASTAR_TRACE_EVENT( Event, State, G, H, F ) \
+    do { if ( m_Trace ) { m_Trace->Record( Event, ( State ).x, ( State ).y, G, H, F ); } } while ( 0 )
+#else
+#define ASTAR_TRACE_EVENT( Event, State, G, H, F ) do { } while ( 0 )
+#endif
+
+#define ASTAR_TRACE_NODE( Event, Index ) \
+    ASTAR_TRACE_EVENT( Event, m_States[Index], m_Nodes[Index].g, m_Nodes[Index].f - m_Nodes[Index].g, m_Nodes[Index].f )
 
 enum class SearchState : short
 {
@@ -84,53 +104,96 @@ using namespace std;
  * efficient and require less memory.
  *
  * The AStar search class. UserState is the users state space type
+ *
+ * With AnyAngle set the search runs as Theta*. A successor whose grand
+ * parent can see it takes the grand parent as its own parent, so the path
+ * is made of straight segments between the turning points only. The user
+ * state then also provides LineOfSight( UserState & ), true when the
+ * straight segment between both states can be walked, and GetDistance(
+ * UserState & ), the cost of that segment, which is the heuristic too.
+ *
+ * The nodes of a search sit in one vector and refer to each other by 32 bit
+ * index. The user states are kept in a second vector at the same indices, so
+ * the fields read on every step stay packed together, and the open list
+ * holds (f, index) pairs so the heap never reads a node while sorting. A node
+ * that gets a cheaper path is pushed again, the entries left behind are
+ * skipped when they are popped.
+ *
+ * The user state may also provide Hash( ), returning the same value for any
+ * two states that are IsSameState. The states already seen are then found
+ * through a hash index, without it they are compared one by one.
  */
-template <class UserState> class AStar
+template <class UserState, bool AnyAngle = false> class AStar
 {
 
 public:
 
+    // Handle of a node, its index in the node storage
+    typedef std::uint32_t NodeIndex;
+
+    enum : NodeIndex { NO_NODE = 0xFFFFFFFF };
+
     /**
-     * A node represents a possible state in the search
-     * The user provided state type is included inside this type
+     * A node represents a possible state in the search. Only the fields the
+     * search reads on every step are kept here, 16 bytes per node. The user
+     * provided state lives at the same index in a vector of its own and is
+     * read when the node is expanded or looked up.
      */
     class Node
     {
 
     public:
 
-        Node *parent; // used during the search to record the parent of successor nodes
-        Node *child; // used after the search for the application to view the search in reverse
-
-        float g; // cost of this node + it's predecessors
-        float h; // heuristic estimate of distance to goal
         float f; // sum of cumulative cost of predecessors and self and heuristic
+        float g; // cost of this node + it's predecessors
+
+        NodeIndex parent; // used during the search to record the parent of successor nodes
+        bool closed; // expanded since it was last pushed on the open list
+    };
+
+private: // classes
+
+    // The open list holds copies of f so the heap never reads the nodes
+    class OpenEntry
+    {
+
+    public:
+
+        float f;
+        NodeIndex node;
+    };
+
+    // For sorting the heap the STL needs compare function that lets us compare
+    // the f value of two entries
+    class OpenCompare
+    {
+
+    public:
 
-        Node()
+        bool operator() ( const OpenEntry &x, const OpenEntry &y ) const
         {
-            parent = nullptr;
-            child = nullptr;
-            g = 0.0f;
-            h = 0.0f;
-            f = 0.0f;
+            return x.f > y.f;
         }
-
-        UserState m_UserState;
     };
 
 private: // data
 
+    // Nodes of the current search and their user states, kept between
+    // searches so the storage is allocated once
+    vector< Node > m_Nodes;
+    vector< UserState > m_States;
+
     // Heap (simple vector but used as a heap, cf. Steve Rabin's game gems article)
     // This is where we will remember which nodes we haven't yet expanded.
-    vector< Node *> m_OpenList;
-
-    // Closed list is a vector.
-    // This is where we will remember which nodes we have expanded.
-    vector< Node * > m_ClosedList;
+    // The closed nodes are flagged in place, there is no closed list.
+    vector< OpenEntry > m_OpenList;
 
     // Successors is a vector filled out by the user each type successors to a node
     // are generated
-    vector< Node * > m_Successors;
+    vector< UserState > m_Successors;
+
+    // Finds the node of a state, through a hash index when the state has Hash( )
+    StateIndex< UserState > m_Index;
 
     queue <Point2D> m_Points;
 
@@ -140,30 +203,21 @@ private: // data
     // Counts steps
     int m_Steps;
 
-    // Start and goal state pointers
-    Node *m_Start;
-    Node *m_Goal;
+    // Goal node reached by the last search
+    NodeIndex m_Goal;
 
-    Node *m_CurrentSolutionNode;
+    NodeIndex m_CurrentSolutionNode;
 
-    // debugging : count memory allocation and free's
-    int m_AllocateNodeCount;
+    // Optional component labelling of the map, used to reject unreachable goals
+    const ConnectedComponents *m_Components;
 
-public: // data
-
-	// For sorting the heap the STL needs compare function that lets us compare
-	// the f value of two nodes
-
-    class HeapCompare_f
-	{
-		public:
-
-			bool operator() ( const Node *x, const Node *y ) const
-			{
-				return x->f > y->f;
-			}
-	};
+    // The goals of the current search, any of them ends it
+    vector< UserState > m_Goals;
 
+#ifdef ASTAR_TRACE
+    // Optional recording of the search events
+    SearchTrace *m_Trace;
+#endif
 
 public: // methods
 
@@ -172,60 +226,93 @@ public: // methods
     AStar( )
     {
         m_State = SearchState::NOT_INITIALISED;
-        m_AllocateNodeCount = 0;
         m_Steps = 0;
+        m_Goal = NO_NODE;
+        m_CurrentSolutionNode = NO_NODE;
+        m_Components = nullptr;
+
+#ifdef ASTAR_TRACE
+        m_Trace = nullptr;
+#endif
+    }
+
+#ifdef ASTAR_TRACE
+    // Record the events of the following searches, nullptr stops recording
+    void SetTrace( SearchTrace *Trace )
+    {
+        m_Trace = Trace;
+    }
+#endif
+
+    // Searches between cells of different components fail straight away,
+    // before any node is allocated. The components must use the same
+    // walkable cells as the GetSuccessors function of the user state.
+    void SetComponents( const ConnectedComponents *Components )
+    {
+        m_Components = Components;
     }
 
     // Advances search
     SearchState ComputePath( UserState Start, UserState Goal )
     {
-        m_CurrentSolutionNode = nullptr;
-        m_AllocateNodeCount = 0;
+        m_Goals.clear( );
+        m_Goals.push_back( Goal );
 
-        m_Start = new Node( );
-        m_AllocateNodeCount += 1;
+        return Search( Start );
+    }
 
-        m_Goal = new Node( );
-        m_AllocateNodeCount += 1;
+    // Search the path to the nearest of several goals in a single pass, the
+    // search ends on the first goal taken from the open list. GetSolutionEnd
+    // returns the goal that was reached.
+    SearchState ComputePath( UserState Start, const vector< UserState > &Goals )
+    {
+        m_Goals.clear( );
 
-        assert(( m_Start != nullptr && m_Goal != nullptr ));
+        for ( const UserState &goal: Goals )
+        {
+            // Goals in another region of the map can never be reached
+            if ( !m_Components || m_Components->IsConnected( Start.x, Start.y, goal.x, goal.y ))
+            {
+                m_Goals.push_back( goal );
+            }
+        }
 
-        m_Start->m_UserState = Start;
-        m_Goal->m_UserState = Goal;
+        return Search( Start );
+    }
 
-        m_State = SearchState::SEARCHING;
+private: // methods
 
-        // Initialise the AStar specific parts of the Start Node
-        // The user only needs fill out the state information
+    SearchState Search( UserState &Start )
+    {
+        FreeAllNodes( );
 
-        m_Start->g = 0;
-        m_Start->h = m_Start->m_UserState.GoalDistanceEstimate( m_Goal->m_UserState );
-        m_Start->f = m_Start->g + m_Start->h;
-        m_Start->parent = nullptr;
+        while ( !m_Points.empty( ))
+        { m_Points.pop( ); }
 
-        // Push the start node on the Open list
+        m_Steps = 0;
 
-        m_OpenList.push_back( m_Start ); // heap now unsorted
+        // The goal is in another region of the map, there is nothing to search
+        if ( m_Goals.empty( ) || ( m_Components && m_Goals.size( ) == 1 &&
+             !m_Components->IsConnected( Start.x, Start.y, m_Goals[0].x, m_Goals[0].y )))
+        {
+            m_State = SearchState::FAILED;
+            return m_State;
+        }
 
-        // Initialise counter for search steps
-        m_Steps = 0;
+        m_State = SearchState::SEARCHING;
 
-		// Firstly break if the user has not initialised the search
-        assert( m_State != SearchState::NOT_INITIALISED );
-        assert( m_State == SearchState::SEARCHING );
+        // Push the start node on the Open list
 
-		// Next I want it to be safe to do a searchstep once the search has succeeded...
-        if ( m_State == SearchState::SUCCEEDED || m_State == SearchState::FAILED )
-		{
-			return m_State; 
-		}
+        NewNode( Start, 0.0f, NO_NODE );
 
         while ( m_State == SearchState::SEARCHING )
         {
+            // Pop the best node (the one with the lowest f)
+            NodeIndex n = PopOpen( );
+
             // Failure is defined as emptying the open list as there is nothing left to
             // search...
-            // New: Allow user abort
-            if ( m_OpenList.empty( ))
+            if ( n == NO_NODE )
             {
                 FreeAllNodes( );
                 m_State = SearchState::FAILED;
@@ -235,313 +322,259 @@ public: // methods
             // Incremement step count
             m_Steps++;
 
-            // Pop the best node (the one with the lowest f)
-            Node *n = m_OpenList.front( ); // get pointer to the node
-            pop_heap( m_OpenList.begin( ), m_OpenList.end( ), HeapCompare_f( ));
-            m_OpenList.pop_back( );
+            ASTAR_TRACE_NODE( TraceEvent::POP, n );
 
             // Check for the goal, once we pop that we're done
-            if ( n->m_UserState.IsGoal( m_Goal->m_UserState ))
+            if ( IsGoal( m_States[n] ))
             {
-                // The user is going to use the Goal Node he passed in
-                // so copy the parent pointer of n
-                m_Goal->parent = n->parent;
-                m_Goal->g = n->g;
-
-                // A special case is that the goal was passed in as the start state
-                // so handle that here
-                if ( false == n->m_UserState.IsSameState( m_Start->m_UserState ))
-                {
-                    m_AllocateNodeCount--;
-                    delete ( n );
-
-                    // set the child pointers in each node (except Goal which has no child)
-                    Node *nodeChild = m_Goal;
-                    Node *nodeParent = m_Goal->parent;
-
-                    do
-                    {
-                        nodeParent->child = nodeChild;
+                m_Goal = n;
 
-                        nodeChild = nodeParent;
-                        nodeParent = nodeParent->parent;
-
-                    }
-                    while ( nodeChild != m_Start ); // Start is always the first node by definition
+                // Store the path from the start to the goal
+                vector< NodeIndex > path;
 
+                for ( NodeIndex node = m_Goal; node != NO_NODE; node = m_Nodes[node].parent )
+                {
+                    path.push_back( node );
                 }
 
-                // delete nodes that aren't needed for the solution
-                FreeUnusedNodes( );
-                // Clear the list of points
-                while ( !m_Points.empty( ))
-                { m_Points.pop( ); }
+                for ( auto node = path.rbegin( ); node != path.rend( ); node++ )
+                {
+                    m_Points.push( Point2D( m_States[*node].x, m_States[*node].y ));
+                }
 
                 m_State = SearchState::SUCCEEDED;
+                return m_State;
+            }
 
-                // Store the start point
-                m_Points.push( Point2D( m_Start->m_UserState.x, m_Start->m_UserState.y ));
-
-                m_CurrentSolutionNode = m_Start;
+            // We now need to generate the successors of this node
+            // The user helps us to do this, and we keep the new states in
+            // m_Successors ...
 
-                while ( m_CurrentSolutionNode->child )
-                {
-                    Node *child = m_CurrentSolutionNode->child;
+            m_Successors.clear( ); // empty vector of successor states to n
 
-                    m_Points.push( Point2D( child->m_UserState.x, child->m_UserState.y ));
+            // User provides this functions and uses AddSuccessor to add each successor of
+            // node 'n' to m_Successors. Only m_Successors grows meanwhile, so the
+            // states given to the user stay in place.
+            const NodeIndex nParent = m_Nodes[n].parent;
+            bool ret = m_States[n].GetSuccessors( this, nParent != NO_NODE ? &m_States[nParent] : NULL );
 
-                    m_CurrentSolutionNode = m_CurrentSolutionNode->child;
-                }
+            if ( !ret )
+            {
+                FreeAllNodes( );
 
+                m_State = SearchState::OUT_OF_MEMORY;
                 return m_State;
             }
-            else // not goal
-            {
 
-                // We now need to generate the successors of this node
-                // The user helps us to do this, and we keep the new nodes in
-                // m_Successors ...
+            // Now handle each successor to the current node ...
+            for ( UserState &successor: m_Successors )
+            {
+                // 	The g value for this successor ...
+                float ValueGSuccessor = m_Nodes[n].g + m_States[n].GetCost( successor );
+                NodeIndex parent = n;
 
-                m_Successors.clear( ); // empty vector of successor nodes to n
+                // In any angle mode the successor may be reached straight from the parent of n
+                ShortcutParent( n, successor, parent, ValueGSuccessor, integral_constant< bool, AnyAngle >( ));
 
-                // User provides this functions and uses AddSuccessor to add each successor of
-                // node 'n' to m_Successors
-                bool ret;
+                // Now we need to find whether the state already has a node, open or
+                // closed. If it has but that node is better (lower g) then we can
+                // forget about this successor
 
-                if ( n->parent )
-                {
-                    ret = n->m_UserState.GetSuccessors( this, &n->parent->m_UserState );
-                }
-                else
-                {
-                    ret = n->m_UserState.GetSuccessors( this, NULL );
-                }
+                NodeIndex existing = m_Index.Find( successor, m_States );
 
-                if ( !ret )
+                if ( existing == NO_NODE )
                 {
+                    // New successor, straight onto the open list
+                    NodeIndex node = NewNode( successor, ValueGSuccessor, parent );
 
-                    // free the nodes that may previously have been added
-                    for ( AStar::Node *successor: m_Successors )
+                    if ( node == NO_NODE )
                     {
-                        m_AllocateNodeCount -= 1;
-                        delete successor;
-                    }
-
-                    m_Successors.clear( ); // empty vector of successor nodes to n
+                        FreeAllNodes( );
 
-                    // free up everything else we allocated
-                    m_AllocateNodeCount--;
-                    delete (( n ));
-                    FreeAllNodes( );
+                        m_State = SearchState::OUT_OF_MEMORY;
+                        return m_State;
+                    }
 
-                    m_State = SearchState::OUT_OF_MEMORY;
-                    return m_State;
+                    continue;
                 }
 
-                // Now handle each successor to the current node ...
-                for ( AStar::Node *successor: m_Successors )
-                {
-
-                    // 	The g value for this successor ...
-                    float ValueGSuccessor = n->g + n->m_UserState.GetCost( successor->m_UserState );
-
-                    // Now we need to find whether the node is on the open or closed lists
-                    // If it is but the node that is already on them is better (lower g)
-                    // then we can forget about this successor
+                Node &node = m_Nodes[existing];
 
-                    // First linear search of open list to find node
-
-                    typename vector <Node *>::iterator openlist_result;
-
-                    for ( openlist_result = m_OpenList.begin( );
-                          openlist_result != m_OpenList.end( ); openlist_result++ )
-                    {
-                        if (( *openlist_result )->m_UserState.IsSameState( successor->m_UserState ))
-                        {
-                            break;
-                        }
-                    }
-
-                    if ( openlist_result != m_OpenList.end( ))
-                    {
+                if ( node.g <= ValueGSuccessor )
+                {
+                    // the one on Open or Closed is cheaper than this one
+                    ASTAR_TRACE_EVENT( TraceEvent::PRUNE, successor, ValueGSuccessor, node.f - node.g,
+                                       ValueGSuccessor + node.f - node.g );
+                    continue;
+                }
 
-                        // we found this state on open
+                // This is the best path so far to this particular state
+                // so lets update its AStar specific data ...
 
-                        if (( *openlist_result )->g <= ValueGSuccessor )
-                        {
-                            m_AllocateNodeCount--;
-                            delete (( successor ));
+                const bool reopened = node.closed;
 
-                            // the one on Open is cheaper than this one
-                            continue;
-                        }
-                    }
+                node.parent = parent;
+                node.g = ValueGSuccessor;
+                node.f = ValueGSuccessor + GoalDistanceEstimate( successor );
+                node.closed = false;
 
-                    typename vector <Node *>::iterator closedlist_result;
+                // Push it again with its new f, the entry it may still have on
+                // the open list is skipped when popped. A closed successor goes
+                // back to the open list the same way.
+                // Fix thanks to ...
+                // Greg Douglas <gregdouglasmail@gmail.com>
+                // who noticed that this code path was incorrect
+                PushOpen( existing );
 
-                    for ( closedlist_result = m_ClosedList.begin( );
-                          closedlist_result != m_ClosedList.end( ); closedlist_result++ )
-                    {
-                        if (( *closedlist_result )->m_UserState.IsSameState(( successor )->m_UserState ))
-                        {
-                            break;
-                        }
-                    }
+                if ( reopened )
+                {
+                    ASTAR_TRACE_NODE( TraceEvent::REOPEN, existing );
+                }
+                else
+                {
+                    ASTAR_TRACE_NODE( TraceEvent::UPDATE, existing );
+                }
+            }
+        }
 
-                    if ( closedlist_result != m_ClosedList.end( ))
-                    {
+        return m_State; // Succeeded bool is false at this point.
+    }
 
-                        // we found this state on closed
+    // Add a node for the state and push it on the open list, NO_NODE when
+    // every handle is in use
+    NodeIndex NewNode( UserState &State, float ValueG, NodeIndex Parent )
+    {
+        if ( m_Nodes.size( ) >= NO_NODE )
+        {
+            return NO_NODE;
+        }
 
-                        if (( *closedlist_result )->g <= ValueGSuccessor )
-                        {
-                            // the one on Closed is cheaper than this one
-                            m_AllocateNodeCount--;
-                            delete (( successor ));
+        Node node;
+        node.f = ValueG + GoalDistanceEstimate( State );
+        node.g = ValueG;
+        node.parent = Parent;
+        node.closed = false;
 
-                            continue;
-                        }
-                    }
+        m_Nodes.push_back( node );
+        m_States.push_back( State );
 
-                    // This node is the best node so far with this particular state
-                    // so lets keep it and set up its AStar specific data ...
+        NodeIndex index = ( NodeIndex ) ( m_Nodes.size( ) - 1 );
+        m_Index.Insert( m_States );
+        PushOpen( index );
+        ASTAR_TRACE_NODE( TraceEvent::PUSH, index );
 
-                    successor->parent = n;
-                    successor->g = ValueGSuccessor;
-                    successor->h = successor->m_UserState.GoalDistanceEstimate( m_Goal->m_UserState );
-                    successor->f = successor->g + successor->h;
+        return index;
+    }
 
-                    // Successor in closed list
-                    // 1 - Update old version of this node in closed list
-                    // 2 - Move it from closed to open list
-                    // 3 - Sort heap again in open list
+    void PushOpen( NodeIndex Index )
+    {
+        OpenEntry entry;
+        entry.f = m_Nodes[Index].f;
+        entry.node = Index;
 
-                    if ( closedlist_result != m_ClosedList.end( ))
-                    {
-                        // Update closed node with successor node AStar data
-                        //*(*closedlist_result) = *(*successor);
-                        ( *closedlist_result )->parent = successor->parent;
-                        ( *closedlist_result )->g = successor->g;
-                        ( *closedlist_result )->h = successor->h;
-                        ( *closedlist_result )->f = successor->f;
+        m_OpenList.push_back( entry );
+        push_heap( m_OpenList.begin( ), m_OpenList.end( ), OpenCompare( ));
+    }
 
-                        // Free successor node
-                        m_AllocateNodeCount--;
-                        delete ( successor );
+    // Pop the open node with the lowest f and close it, NO_NODE once the
+    // open list is empty. The entries left behind by a later push of their
+    // node are dropped on the way, only then is a node read.
+    NodeIndex PopOpen( )
+    {
+        while ( !m_OpenList.empty( ))
+        {
+            const OpenEntry entry = m_OpenList.front( );
 
-                        // Push closed node into open list
-                        m_OpenList.push_back(( *closedlist_result ));
+            pop_heap( m_OpenList.begin( ), m_OpenList.end( ), OpenCompare( ));
+            m_OpenList.pop_back( );
 
-                        // Remove closed node from closed list
-                        m_ClosedList.erase( closedlist_result );
+            Node &node = m_Nodes[entry.node];
 
-                        // Sort back element into heap
-                        push_heap( m_OpenList.begin( ), m_OpenList.end( ), HeapCompare_f( ));
+            if ( !node.closed && node.f == entry.f )
+            {
+                node.closed = true;
+                return entry.node;
+            }
+        }
 
-                        // Fix thanks to ...
-                        // Greg Douglas <gregdouglasmail@gmail.com>
-                        // who noticed that this code path was incorrect
-                        // Here we have found a new state which is already CLOSED
+        return NO_NODE;
+    }
 
-                    }
+    // The state is any of the goals
+    bool IsGoal( UserState &State )
+    {
+        for ( UserState &goal: m_Goals )
+        {
+            if ( State.IsGoal( goal ))
+            {
+                return true;
+            }
+        }
 
-                        // Successor in open list
-                        // 1 - Update old version of this node in open list
-                        // 2 - sort heap again in open list
+        return false;
+    }
 
-                    else if ( openlist_result != m_OpenList.end( ))
-                    {
-                        // Update open node with successor node AStar data
-                        //*(*openlist_result) = *(*successor);
-                        ( *openlist_result )->parent = successor->parent;
-                        ( *openlist_result )->g = successor->g;
-                        ( *openlist_result )->h = successor->h;
-                        ( *openlist_result )->f = successor->f;
-
-                        // Free successor node
-                        m_AllocateNodeCount--;
-                        delete ( successor );
-
-                        // re-make the heap
-                        // make_heap rather than sort_heap is an essential bug fix
-                        // thanks to Mike Ryynanen for pointing this out and then explaining
-                        // it in detail. sort_heap called on an invalid heap does not work
-                        make_heap( m_OpenList.begin( ), m_OpenList.end( ), HeapCompare_f( ));
-                    }
+    // The heuristic towards several goals is the smallest of the estimates,
+    // which stays admissible
+    float GoalDistanceEstimate( UserState &State )
+    {
+        float h = GoalDistanceEstimate( State, m_Goals[0], integral_constant< bool, AnyAngle >( ));
 
-                        // New successor
-                        // 1 - Move it from successors to open list
-                        // 2 - sort heap again in open list
+        for ( size_t i = 1; i < m_Goals.size( ); i++ )
+        {
+            h = min( h, GoalDistanceEstimate( State, m_Goals[i], integral_constant< bool, AnyAngle >( )));
+        }
 
-                    else
-                    {
-                        // Push successor node into open list
-                        m_OpenList.push_back(( successor ));
+        return h;
+    }
 
-                        // Sort back element into heap
-                        push_heap( m_OpenList.begin( ), m_OpenList.end( ), HeapCompare_f( ));
-                    }
+    float GoalDistanceEstimate( UserState &State, UserState &Goal, false_type )
+    {
+        return State.GoalDistanceEstimate( Goal );
+    }
 
-                }
+    // Grid estimates such as the Manhattan distance overestimate any angle
+    // paths, the straight line distance does not
+    float GoalDistanceEstimate( UserState &State, UserState &Goal, true_type )
+    {
+        return State.GetDistance( Goal );
+    }
 
-                // push n onto Closed, as we have expanded it now
+    void ShortcutParent( NodeIndex, UserState &, NodeIndex &, float &, false_type )
+    { }
 
-                m_ClosedList.push_back( n );
+    // Theta*, path 2: skip n if its parent has line of sight to the successor
+    void ShortcutParent( NodeIndex n, UserState &Successor, NodeIndex &Parent, float &ValueG, true_type )
+    {
+        NodeIndex grandParent = m_Nodes[n].parent;
 
-            } // end else (not goal so expand)
+        if ( grandParent != NO_NODE && m_States[grandParent].LineOfSight( Successor ))
+        {
+            float ValueGShortcut = m_Nodes[grandParent].g + m_States[grandParent].GetDistance( Successor );
 
+            if ( ValueGShortcut <= ValueG )
+            {
+                Parent = grandParent;
+                ValueG = ValueGShortcut;
+            }
         }
-
-        return m_State; // Succeeded bool is false at this point.
     }
 
+public: // methods
+
 	// User calls this to add a successor to a list of successors
 	// when expanding the search frontier
 	bool AddSuccessor( UserState &State )
 	{
-		Node *node = new Node();
-		m_AllocateNodeCount += 1;
-
-        node->m_UserState = State;
-        m_Successors.push_back( node );
+        m_Successors.push_back( State );
         return true;
     }
 
 	// Free the solution nodes
-	// This is done to clean up all used Node memory when you are done with the
-	// search
+	// The storage is kept for the next search, only the nodes are dropped
 	void FreeSolutionNodes()
 	{
-		Node *n = m_Start;
-
-		if( m_Start->child )
-		{
-			do
-			{
-				Node *del = n;
-				n = n->child;
-
-                m_AllocateNodeCount--;
-                delete ( del );
-
-            }
-            while ( n != m_Goal );
-
-            m_AllocateNodeCount--;
-            delete ( n ); // Delete the goal
-
-		}
-		else
-		{
-			// if the start node is the solution we need to just delete the start and goal
-			// nodes
-            m_AllocateNodeCount--;
-            delete ( m_Start );
-
-            m_AllocateNodeCount--;
-            delete ( m_Goal );
-        }
-
+        FreeAllNodes( );
 	}
 
     SearchState GetSearchState( )
@@ -569,9 +602,10 @@ public: // methods
 	UserState *GetSolutionEnd()
 	{
 		m_CurrentSolutionNode = m_Goal;
-		if( m_Goal )
+
+		if( m_Goal != NO_NODE )
 		{
-			return &m_Goal->m_UserState;
+			return &m_States[m_Goal];
 		}
 		else
 		{
@@ -582,16 +616,13 @@ public: // methods
 	// Step solution iterator backwards
 	UserState *GetSolutionPrev()
 	{
-		if( m_CurrentSolutionNode )
+		if( m_CurrentSolutionNode != NO_NODE )
 		{
-			if( m_CurrentSolutionNode->parent )
-			{
+			m_CurrentSolutionNode = m_Nodes[m_CurrentSolutionNode].parent;
 
-				Node *parent = m_CurrentSolutionNode->parent;
-
-				m_CurrentSolutionNode = m_CurrentSolutionNode->parent;
-
-				return &parent->m_UserState;
+			if( m_CurrentSolutionNode != NO_NODE )
+			{
+				return &m_States[m_CurrentSolutionNode];
 			}
 		}
 
@@ -600,63 +631,19 @@ public: // methods
 
 private: // methods
 
-	// This is called when a search fails or is cancelled to free all used
-	// memory 
+	// This is called when a search ends, fails or is cancelled to drop all
+	// the nodes. The vectors keep their memory for the next search.
 	void FreeAllNodes()
 	{
-		// iterate open list and delete all nodes
-        for ( AStar::Node *iterOpen: m_OpenList )
-        {
-            m_AllocateNodeCount -= 1;
-            delete iterOpen;
-		}
-
-		m_OpenList.clear();
-
-		// iterate closed list and delete unused nodes
-        for ( AStar::Node *iterClosed: m_ClosedList )
-        {
-            m_AllocateNodeCount -= 1;
-            delete iterClosed;
-		}
-
-		m_ClosedList.clear();
-
-		// delete the goal
-        m_AllocateNodeCount -= 1;
-        delete m_Goal;
-	}
-
-
-	// This call is made by the search class when the search ends. A lot of nodes may be
-	// created that are still present when the search ends. They will be deleted by this 
-	// routine once the search ends
-	void FreeUnusedNodes()
-	{
-		// iterate open list and delete unused nodes
-		for( AStar::Node *iterOpen: m_OpenList)
-		{
-			if( !iterOpen->child )
-			{
-				m_AllocateNodeCount -= 1;
-				delete iterOpen;
-			}
-		}
-
-		m_OpenList.clear();
+        m_Index.Clear( m_States );
 
-		// iterate closed list and delete unused nodes
-		for( AStar::Node *iterClosed: m_ClosedList )
-		{
-			if( !iterClosed->child )
-			{
-                m_AllocateNodeCount -= 1;
-                delete iterClosed;
-			}
-		}
+        m_Nodes.clear( );
+        m_States.clear( );
+        m_OpenList.clear( );
 
-		m_ClosedList.clear();
+        m_Goal = NO_NODE;
+        m_CurrentSolutionNode = NO_NODE;
 	}
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,493 @@
+/*
+ * Connected component labelling of a grid
+ *
+ * Part of the A* Algorithm Implementation using STL, see AStar.hpp for
+ * copyright and license information.
+ *
+ */
+
+#ifndef CONNECTED_COMPONENTS_HPP
+#define CONNECTED_COMPONENTS_HPP
+
+#include <vector>
+#include <cstdint>
+
+/**
+ * Labels every walkable cell of a grid with the 4-connected component it
+ * belongs to, so a search can tell in constant time that the goal cannot be
+ * reached from the start instead of flood filling the whole region first.
+ *
+ * The labels index a union-find forest. Unblocking a cell merges the
+ * components around it. Blocking a cell may split its component, so a
+ * breadth first search is started from each walkable neighbour in lockstep
+ * and every piece that runs out of cells before meeting the others is given
+ * a new label. Only the smaller pieces are walked, never the whole component.
+ *
+ * Every edit adds labels and the labels left without cells are not freed
+ * one by one. Once the forest holds twice as many labels as there are
+ * cells, the labels still in use are renumbered from zero, so the forest
+ * stays bounded under any number of edits.
+ */
+class ConnectedComponents
+{
+
+public:
+
+    // Component of blocked and out of map cells
+    enum : int { BLOCKED = -1 };
+
+private: // data
+
+    int m_Width;
+    int m_Height;
+
+    // Walkable flag of each cell
+    std::vector <char> m_Walkable;
+
+    // Label of each cell, an index into the union-find forest
+    std::vector <int> m_Labels;
+
+    // Union-find forest, m_Parent of a root is itself
+    std::vector <int> m_Parent;
+    std::vector <int> m_Size;
+
+    // Scratch space of Block, m_Mark holds the epoch plus the neighbour
+    // that reached the cell
+    std::vector <std::uint32_t> m_Mark;
+    std::uint32_t m_Epoch;
+
+public: // methods
+
+    // Walkable is any function or functor taking (x, y) and returning true
+    // when the search can pass through the cell
+    template <class IsWalkable>
+    ConnectedComponents( int Width, int Height, IsWalkable Walkable )
+    {
+        m_Width = Width;
+        m_Height = Height;
+
+        m_Walkable.resize( Width * Height );
+        m_Labels.assign( Width * Height, BLOCKED );
+        m_Mark.assign( Width * Height, 0 );
+        m_Epoch = 0;
+
+        for ( int y = 0; y < Height; y++ )
+        {
+            for ( int x = 0; x < Width; x++ )
+            {
+                m_Walkable[( y * Width ) + x] = Walkable( x, y ) ? 1 : 0;
+            }
+        }
+
+        // Flood fill each unlabelled walkable cell
+
+        std::vector <int> open;
+
+        for ( int cell = 0; cell < Width * Height; cell++ )
+        {
+            if ( !m_Walkable[cell] || m_Labels[cell] != BLOCKED )
+            {
+                continue;
+            }
+
+            int label = NewLabel( 0 );
+
+            m_Labels[cell] = label;
+            open.push_back( cell );
+
+            while ( !open.empty( ))
+            {
+                int current = open.back( );
+                open.pop_back( );
+                m_Size[label] += 1;
+
+                int neighbours[4];
+                int count = GetNeighbours( current, neighbours );
+
+                for ( int i = 0; i < count; i++ )
+                {
+                    if ( m_Labels[neighbours[i]] == BLOCKED )
+                    {
+                        m_Labels[neighbours[i]] = label;
+                        open.push_back( neighbours[i] );
+                    }
+                }
+            }
+        }
+    }
+
+    // Component of the cell (x, y), BLOCKED if it can not be walked
+    int GetComponent( int x, int y ) const
+    {
+        if ( x < 0 || x >= m_Width || y < 0 || y >= m_Height )
+        {
+            return BLOCKED;
+        }
+
+        int label = m_Labels[( y * m_Width ) + x];
+
+        if ( label == BLOCKED )
+        {
+            return BLOCKED;
+        }
+
+        return Find( label );
+    }
+
+    // True if a path may exist between the two cells
+    bool IsConnected( int x0, int y0, int x1, int y1 ) const
+    {
+        int component = GetComponent( x0, y0 );
+
+        return component != BLOCKED && component == GetComponent( x1, y1 );
+    }
+
+    // Make the cell (x, y) walkable and merge the components around it
+    void Unblock( int x, int y )
+    {
+        if ( x < 0 || x >= m_Width || y < 0 || y >= m_Height )
+        {
+            return;
+        }
+
+        int cell = ( y * m_Width ) + x;
+
+        if ( m_Walkable[cell] )
+        {
+            return;
+        }
+
+        CompactLabels( );
+
+        m_Walkable[cell] = 1;
+
+        int label = NewLabel( 1 );
+        m_Labels[cell] = label;
+
+        int neighbours[4];
+        int count = GetNeighbours( cell, neighbours );
+
+        for ( int i = 0; i < count; i++ )
+        {
+            label = Union( label, m_Labels[neighbours[i]] );
+        }
+    }
+
+    // Make the cell (x, y) unwalkable and split its component if needed
+    void Block( int x, int y )
+    {
+        if ( x < 0 || x >= m_Width || y < 0 || y >= m_Height )
+        {
+            return;
+        }
+
+        int cell = ( y * m_Width ) + x;
+
+        if ( !m_Walkable[cell] )
+        {
+            return;
+        }
+
+        CompactLabels( );
+
+        int root = Compress( m_Labels[cell] );
+
+        m_Walkable[cell] = 0;
+        m_Labels[cell] = BLOCKED;
+        m_Size[root] -= 1;
+
+        int neighbours[4];
+        int count = GetNeighbours( cell, neighbours );
+
+        // With a single neighbour the rest of the component stays connected
+        if ( count < 2 )
+        {
+            return;
+        }
+
+        // One breadth first search per neighbour, fronts that meet are joined
+        // in a group. A group that runs out of cells while other groups are
+        // still searching is a piece cut off from the rest.
+
+        if ( m_Epoch > UINT32_MAX - 8 )
+        {
+            m_Mark.assign( m_Mark.size( ), 0 );
+            m_Epoch = 0;
+        }
+
+        m_Epoch += 4;
+
+        std::vector <int> fronts[4];
+        std::size_t heads[4] = { 0, 0, 0, 0 };
+        int group[4];
+        bool active[4];
+
+        for ( int i = 0; i < count; i++ )
+        {
+            fronts[i].push_back( neighbours[i] );
+            group[i] = i;
+            active[i] = true;
+
+            m_Mark[neighbours[i]] = m_Epoch + i;
+        }
+
+        while ( CountActiveGroups( group, active, count ) > 1 )
+        {
+            for ( int i = 0; i < count; i++ )
+            {
+                if ( !active[i] || heads[i] == fronts[i].size( ))
+                {
+                    continue;
+                }
+
+                int current = fronts[i][heads[i]++];
+
+                int next[4];
+                int nextCount = GetNeighbours( current, next );
+
+                for ( int n = 0; n < nextCount; n++ )
+                {
+                    std::uint32_t mark = m_Mark[next[n]];
+
+                    if ( mark >= m_Epoch )
+                    {
+                        JoinGroups( group, count, group[mark - m_Epoch], group[i] );
+                    }
+                    else
+                    {
+                        m_Mark[next[n]] = m_Epoch + i;
+                        fronts[i].push_back( next[n] );
+                    }
+                }
+            }
+
+            // Give a new label to each group that has finished while others
+            // are still searching
+
+            for ( int g = 0; g < count; g++ )
+            {
+                if ( !IsGroupFinished( g, group, active, heads, fronts, count ) ||
+                     CountActiveGroups( group, active, count ) < 2 )
+                {
+                    continue;
+                }
+
+                int size = 0;
+
+                for ( int i = 0; i < count; i++ )
+                {
+                    if ( group[i] == g )
+                    {
+                        size += ( int ) fronts[i].size( );
+                    }
+                }
+
+                int label = NewLabel( size );
+                m_Size[root] -= size;
+
+                for ( int i = 0; i < count; i++ )
+                {
+                    if ( group[i] == g )
+                    {
+                        for ( int piece : fronts[i] )
+                        {
+                            m_Labels[piece] = label;
+                        }
+
+                        active[i] = false;
+                    }
+                }
+            }
+        }
+    }
+
+    int GetWidth( ) const
+    { return m_Width; }
+
+    int GetHeight( ) const
+    { return m_Height; }
+
+    // Size of the union-find forest, at most twice the number of cells plus
+    // the labels of a single edit
+    int GetNumberLabels( ) const
+    { return ( int ) m_Parent.size( ); }
+
+private: // methods
+
+    int NewLabel( int Size )
+    {
+        m_Parent.push_back(( int ) m_Parent.size( ));
+        m_Size.push_back( Size );
+
+        return ( int ) m_Parent.size( ) - 1;
+    }
+
+    // Renumber the labels still used by a cell once the forest has grown to
+    // twice the number of cells, each root becomes a label of its own
+    void CompactLabels( )
+    {
+        const std::size_t cells = m_Labels.size( );
+
+        if ( m_Parent.size( ) < cells * 2 )
+        {
+            return;
+        }
+
+        std::vector <int> renumbered( m_Parent.size( ), BLOCKED );
+        std::vector <int> parent;
+        std::vector <int> size;
+
+        for ( std::size_t cell = 0; cell < cells; cell++ )
+        {
+            if ( m_Labels[cell] == BLOCKED )
+            {
+                continue;
+            }
+
+            int root = Find( m_Labels[cell] );
+
+            if ( renumbered[root] == BLOCKED )
+            {
+                renumbered[root] = ( int ) parent.size( );
+                parent.push_back(( int ) parent.size( ));
+                size.push_back( m_Size[root] );
+            }
+
+            m_Labels[cell] = renumbered[root];
+        }
+
+        m_Parent.swap( parent );
+        m_Size.swap( size );
+    }
+
+    // Queries do not compress the paths so they can run concurrently,
+    // union by size keeps the trees shallow
+    int Find( int label ) const
+    {
+        while ( m_Parent[label] != label )
+        {
+            label = m_Parent[label];
+        }
+
+        return label;
+    }
+
+    int Compress( int label )
+    {
+        int root = Find( label );
+
+        while ( m_Parent[label] != root )
+        {
+            int next = m_Parent[label];
+            m_Parent[label] = root;
+            label = next;
+        }
+
+        return root;
+    }
+
+    int Union( int a, int b )
+    {
+        a = Compress( a );
+        b = Compress( b );
+
+        if ( a == b )
+        {
+            return a;
+        }
+
+        if ( m_Size[a] < m_Size[b] )
+        {
+            int swap = a;
+            a = b;
+            b = swap;
+        }
+
+        m_Parent[b] = a;
+        m_Size[a] += m_Size[b];
+
+        return a;
+    }
+
+    // Fill out the walkable 4-connected neighbours of a cell
+    int GetNeighbours( int cell, int *neighbours ) const
+    {
+        int x = cell % m_Width;
+        int y = cell / m_Width;
+        int count = 0;
+
+        if ( x > 0 && m_Walkable[cell - 1] )
+        { neighbours[count++] = cell - 1; }
+
+        if ( x < m_Width - 1 && m_Walkable[cell + 1] )
+        { neighbours[count++] = cell + 1; }
+
+        if ( y > 0 && m_Walkable[cell - m_Width] )
+        { neighbours[count++] = cell - m_Width; }
+
+        if ( y < m_Height - 1 && m_Walkable[cell + m_Width] )
+        { neighbours[count++] = cell + m_Width; }
+
+        return count;
+    }
+
+    static void JoinGroups( int *group, int count, int from, int to )
+    {
+        if ( from == to )
+        {
+            return;
+        }
+
+        for ( int i = 0; i < count; i++ )
+        {
+            if ( group[i] == from )
+            {
+                group[i] = to;
+            }
+        }
+    }
+
+    static int CountActiveGroups( const int *group, const bool *active, int count )
+    {
+        int groups = 0;
+
+        for ( int g = 0; g < count; g++ )
+        {
+            for ( int i = 0; i < count; i++ )
+            {
+                if ( active[i] && group[i] == g )
+                {
+                    groups += 1;
+                    break;
+                }
+            }
+        }
+
+        return groups;
+    }
+
+    static bool IsGroupFinished( int g, const int *group, const bool *active,
+                                 const std::size_t *heads, const std::vector <int> *fronts, int count )
+    {
+        bool member = false;
+
+        for ( int i = 0; i < count; i++ )
+        {
+            if ( group[i] != g )
+            {
+                continue;
+            }
+
+            if ( !active[i] || heads[i] != fronts[i].size( ))
+            {
+                return false;
+            }
+
+            member = true;
+        }
+
+        return member;
+    }
+};
+
+#endif
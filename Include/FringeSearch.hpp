@@ -0,0 +1,397 @@
+/*
+ * Fringe Search implementation using STL
+ *
+ * Part of the A* Algorithm Implementation using STL, see AStar.hpp for
+ * copyright and license information.
+ *
+ */
+
+#ifndef FRINGE_SEARCH_HPP
+#define FRINGE_SEARCH_HPP
+
+#include "AStar.hpp"
+
+/**
+ * Fringe Search (Bjornsson, Enzenberger, Holte and Schaeffer, 2005) finds
+ * the same optimal paths as AStar without a priority queue. The fringe is a
+ * doubly linked list walked from head to tail. Nodes whose f is within the
+ * threshold are expanded now, the others are left for a later pass, and the
+ * next threshold is the smallest f that was left. On maps with many equal f
+ * values most nodes are expanded within the pass they are found, and no
+ * heap ordering is maintained at all.
+ *
+ * It takes the same UserState as AStar and has the same interface, so it
+ * can be swapped in where AStar is used. As in AStar the nodes sit in one
+ * vector and refer to each other by 32 bit index, and the states already
+ * seen are found through a StateIndex.
+ */
+template <class UserState> class FringeSearch
+{
+
+public:
+
+    // Handle of a node, its index in the node storage
+    typedef std::uint32_t NodeIndex;
+
+    enum : NodeIndex { NO_NODE = 0xFFFFFFFF };
+
+    // The user state of a node lives at the same index in a vector of its own
+    class Node
+    {
+
+    public:
+
+        NodeIndex parent; // best known predecessor
+
+        // Links of the fringe list
+        NodeIndex prev;
+        NodeIndex next;
+
+        float g; // cost of this node + it's predecessors
+        float h; // heuristic estimate of distance to goal
+
+        bool inFringe;
+    };
+
+private: // data
+
+    // Every node created by the search, the cache of the fringe search
+    // paper. The vectors keep their memory for the next search.
+    vector< Node > m_Nodes;
+    vector< UserState > m_States;
+
+    // Finds the node of a state, through a hash index when the state has Hash( )
+    StateIndex< UserState > m_Index;
+
+    // Head and tail of the fringe list
+    NodeIndex m_Head;
+    NodeIndex m_Tail;
+
+    // Successors filled out by the user for the node being expanded
+    vector< UserState > m_Successors;
+
+    queue <Point2D> m_Points;
+
+    // State
+    SearchState m_State;
+
+    // Counts expansions
+    int m_Steps;
+
+    // Number of passes over the fringe
+    int m_Iterations;
+
+    // Optional component labelling of the map, used to reject unreachable goals
+    const ConnectedComponents *m_Components;
+
+public: // methods
+
+    FringeSearch( )
+    {
+        m_Head = NO_NODE;
+        m_Tail = NO_NODE;
+        m_State = SearchState::NOT_INITIALISED;
+        m_Steps = 0;
+        m_Iterations = 0;
+        m_Components = nullptr;
+    }
+
+    void SetComponents( const ConnectedComponents *Components )
+    {
+        m_Components = Components;
+    }
+
+    SearchState ComputePath( UserState Start, UserState Goal )
+    {
+        FreeAllNodes( );
+
+        while ( !m_Points.empty( ))
+        { m_Points.pop( ); }
+
+        m_Steps = 0;
+        m_Iterations = 0;
+
+        if ( m_Components && !m_Components->IsConnected( Start.x, Start.y, Goal.x, Goal.y ))
+        {
+            m_State = SearchState::FAILED;
+            return m_State;
+        }
+
+        m_State = SearchState::SEARCHING;
+
+        NodeIndex start = NewNode( Start, Goal );
+
+        if ( start == NO_NODE )
+        {
+            m_State = SearchState::OUT_OF_MEMORY;
+            return m_State;
+        }
+
+        PushBack( start );
+
+        float threshold = m_Nodes[start].h;
+        NodeIndex goal = NO_NODE;
+
+        while ( goal == NO_NODE && m_Head != NO_NODE )
+        {
+            m_Iterations++;
+
+            float nextThreshold = FLT_MAX;
+            NodeIndex n = m_Head;
+
+            while ( n != NO_NODE )
+            {
+                float f = m_Nodes[n].g + m_Nodes[n].h;
+
+                // Too far for this pass, look at it again in the next one
+                if ( f > threshold )
+                {
+                    nextThreshold = min( nextThreshold, f );
+                    n = m_Nodes[n].next;
+                    continue;
+                }
+
+                if ( m_States[n].IsGoal( Goal ))
+                {
+                    goal = n;
+                    break;
+                }
+
+                m_Steps++;
+
+                m_Successors.clear( );
+
+                // Only m_Successors grows meanwhile, so the states given to
+                // the user stay in place
+                const NodeIndex nParent = m_Nodes[n].parent;
+
+                if ( !m_States[n].GetSuccessors( this, nParent != NO_NODE ? &m_States[nParent] : nullptr ))
+                {
+                    FreeAllNodes( );
+
+                    m_State = SearchState::OUT_OF_MEMORY;
+                    return m_State;
+                }
+
+                // Successors go right after n so they are visited in this same
+                // pass, which is what keeps the expansion order depth first
+
+                NodeIndex insertAfter = n;
+
+                for ( UserState &state: m_Successors )
+                {
+                    float ValueGSuccessor = m_Nodes[n].g + m_States[n].GetCost( state );
+                    NodeIndex successor = m_Index.Find( state, m_States );
+
+                    if ( successor != NO_NODE )
+                    {
+                        // the cached one is cheaper than this one
+                        if ( m_Nodes[successor].g <= ValueGSuccessor )
+                        {
+                            continue;
+                        }
+
+                        if ( m_Nodes[successor].inFringe )
+                        {
+                            Remove( successor );
+                        }
+                    }
+                    else
+                    {
+                        successor = NewNode( state, Goal );
+
+                        if ( successor == NO_NODE )
+                        {
+                            FreeAllNodes( );
+
+                            m_State = SearchState::OUT_OF_MEMORY;
+                            return m_State;
+                        }
+                    }
+
+                    m_Nodes[successor].g = ValueGSuccessor;
+                    m_Nodes[successor].parent = n;
+
+                    InsertAfter( insertAfter, successor );
+                    insertAfter = successor;
+                }
+
+                NodeIndex next = m_Nodes[n].next;
+                Remove( n );
+                n = next;
+            }
+
+            threshold = nextThreshold;
+        }
+
+        if ( goal == NO_NODE )
+        {
+            FreeAllNodes( );
+
+            m_State = SearchState::FAILED;
+            return m_State;
+        }
+
+        // Store the path from start to goal
+
+        vector< NodeIndex > path;
+
+        for ( NodeIndex node = goal; node != NO_NODE; node = m_Nodes[node].parent )
+        {
+            path.push_back( node );
+        }
+
+        for ( auto node = path.rbegin( ); node != path.rend( ); node++ )
+        {
+            m_Points.push( Point2D( m_States[*node].x, m_States[*node].y ));
+        }
+
+        FreeAllNodes( );
+
+        m_State = SearchState::SUCCEEDED;
+        return m_State;
+    }
+
+    // User calls this to add a successor to a list of successors
+    // when expanding the search frontier
+    bool AddSuccessor( UserState &State )
+    {
+        m_Successors.push_back( State );
+        return true;
+    }
+
+    // The nodes are freed as soon as the path is stored, kept so that
+    // FringeSearch can be used where AStar is
+    void FreeSolutionNodes( )
+    { }
+
+    SearchState GetSearchState( )
+    { return m_State; }
+
+    unsigned int GetNumberSteps( )
+    { return m_Steps; }
+
+    unsigned int GetNumberIterations( )
+    { return m_Iterations; }
+
+    // Functions for traversing the solution
+
+    Point2D Walk( )
+    {
+        Point2D point = m_Points.front( );
+        m_Points.pop( );
+
+        return point;
+    }
+
+    unsigned int GetSizePath( )
+    {
+        return m_Points.size( );
+    }
+
+private: // methods
+
+    // Add a node for the state outside the fringe, NO_NODE when every
+    // handle is in use
+    NodeIndex NewNode( UserState &State, UserState &Goal )
+    {
+        if ( m_Nodes.size( ) >= NO_NODE )
+        {
+            return NO_NODE;
+        }
+
+        Node node;
+        node.parent = NO_NODE;
+        node.prev = NO_NODE;
+        node.next = NO_NODE;
+        node.g = 0.0f;
+        node.h = State.GoalDistanceEstimate( Goal );
+        node.inFringe = false;
+
+        m_Nodes.push_back( node );
+        m_States.push_back( State );
+        m_Index.Insert( m_States );
+
+        return ( NodeIndex ) ( m_Nodes.size( ) - 1 );
+    }
+
+    void PushBack( NodeIndex Index )
+    {
+        Node &node = m_Nodes[Index];
+
+        node.prev = m_Tail;
+        node.next = NO_NODE;
+
+        if ( m_Tail != NO_NODE )
+        {
+            m_Nodes[m_Tail].next = Index;
+        }
+        else
+        {
+            m_Head = Index;
+        }
+
+        m_Tail = Index;
+        node.inFringe = true;
+    }
+
+    void InsertAfter( NodeIndex Position, NodeIndex Index )
+    {
+        Node &position = m_Nodes[Position];
+        Node &node = m_Nodes[Index];
+
+        node.prev = Position;
+        node.next = position.next;
+
+        if ( position.next != NO_NODE )
+        {
+            m_Nodes[position.next].prev = Index;
+        }
+        else
+        {
+            m_Tail = Index;
+        }
+
+        position.next = Index;
+        node.inFringe = true;
+    }
+
+    void Remove( NodeIndex Index )
+    {
+        Node &node = m_Nodes[Index];
+
+        if ( node.prev != NO_NODE )
+        {
+            m_Nodes[node.prev].next = node.next;
+        }
+        else
+        {
+            m_Head = node.next;
+        }
+
+        if ( node.next != NO_NODE )
+        {
+            m_Nodes[node.next].prev = node.prev;
+        }
+        else
+        {
+            m_Tail = node.prev;
+        }
+
+        node.prev = NO_NODE;
+        node.next = NO_NODE;
+        node.inFringe = false;
+    }
+
+    void FreeAllNodes( )
+    {
+        m_Index.Clear( m_States );
+
+        m_Nodes.clear( );
+        m_States.clear( );
+        m_Head = NO_NODE;
+        m_Tail = NO_NODE;
+    }
+};
+
+#endif
@@ -0,0 +1,550 @@
+/*
+ * Sparse graph stored in compressed sparse row form and its search
+ *
+ * Part of the A* Algorithm Implementation using STL, see AStar.hpp for
+ * copyright and license information.
+ *
+ */
+
+#ifndef GRAPH_HPP
+#define GRAPH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "AStar.hpp"
+#include "MappedFile.hpp"
+
+/**
+ * A directed graph with integer node ids, such as a road network or the
+ * polygons of a navigation mesh. The edges leaving node n are the edges
+ * offsets[n] up to offsets[n + 1], so the whole graph is four flat arrays and
+ * a search walks them without calling back into user code. Nodes may carry
+ * (x, y) coordinates used for the heuristic of GraphSearch.
+ *
+ * A graph is built in memory from a list of edges, and can be written to a
+ * file that is mapped in memory when it is opened, so large graphs load
+ * without being parsed.
+ *
+ * File layout, all values in the byte order of the machine that wrote it:
+ *
+ *   char     magic[4]           "CSR1"
+ *   uint32   nodes, flags, reserved  flags bit 0: the nodes have coordinates
+ *   uint64   edges
+ *   uint64   offsets[nodes + 1]  first edge of each node
+ *   uint32   targets[edges]
+ *   float    costs[edges]
+ *   float    coordinates[nodes * 2]  x then y of each node, if any
+ */
+class Graph
+{
+
+public:
+
+    enum : std::uint32_t { HAS_COORDINATES = 1 };
+
+    class Edge
+    {
+
+    public:
+
+        std::uint32_t source;
+        std::uint32_t target;
+        float cost;
+
+        Edge( std::uint32_t Source, std::uint32_t Target, float Cost )
+        {
+            source = Source;
+            target = Target;
+            cost = Cost;
+        }
+    };
+
+private: // data
+
+    MappedFile m_File;
+
+    // Arrays of a graph built in memory
+    std::vector <std::uint64_t> m_OwnedOffsets;
+    std::vector <std::uint32_t> m_OwnedTargets;
+    std::vector <float> m_OwnedCosts;
+    std::vector <float> m_OwnedCoordinates;
+
+    std::uint32_t m_NumberNodes;
+    std::uint64_t m_NumberEdges;
+
+    // Point in the mapped file or in the owned arrays
+    const std::uint64_t *m_Offsets;
+    const std::uint32_t *m_Targets;
+    const float *m_Costs;
+    const float *m_Coordinates;
+
+public: // methods
+
+    Graph( )
+    {
+        Reset( );
+    }
+
+    ~Graph( )
+    {
+        Close( );
+    }
+
+    Graph( const Graph & ) = delete;
+    Graph &operator=( const Graph & ) = delete;
+
+    // Build the graph from its edges, in any order. Coordinates is either
+    // empty or holds x then y for each node. Returns false if an edge refers
+    // to a node that does not exist.
+    bool Assign( std::uint32_t Nodes, const std::vector <Edge> &Edges,
+                 const std::vector <float> &Coordinates = std::vector <float>( ))
+    {
+        Close( );
+
+        if ( !Coordinates.empty( ) && Coordinates.size( ) != ( std::size_t ) Nodes * 2 )
+        {
+            return false;
+        }
+
+        // Counting sort of the edges by source
+
+        m_OwnedOffsets.assign(( std::size_t ) Nodes + 1, 0 );
+
+        for ( const Edge &edge : Edges )
+        {
+            if ( edge.source >= Nodes || edge.target >= Nodes )
+            {
+                Close( );
+                return false;
+            }
+
+            m_OwnedOffsets[edge.source + 1] += 1;
+        }
+
+        for ( std::uint32_t node = 0; node < Nodes; node++ )
+        {
+            m_OwnedOffsets[node + 1] += m_OwnedOffsets[node];
+        }
+
+        std::vector <std::uint64_t> next( m_OwnedOffsets.begin( ), m_OwnedOffsets.end( ) - 1 );
+
+        m_OwnedTargets.resize( Edges.size( ));
+        m_OwnedCosts.resize( Edges.size( ));
+
+        for ( const Edge &edge : Edges )
+        {
+            const std::uint64_t index = next[edge.source]++;
+
+            m_OwnedTargets[index] = edge.target;
+            m_OwnedCosts[index] = edge.cost;
+        }
+
+        m_OwnedCoordinates = Coordinates;
+
+        m_NumberNodes = Nodes;
+        m_NumberEdges = Edges.size( );
+        m_Offsets = m_OwnedOffsets.data( );
+        m_Targets = m_OwnedTargets.data( );
+        m_Costs = m_OwnedCosts.data( );
+        m_Coordinates = m_OwnedCoordinates.empty( ) ? nullptr : m_OwnedCoordinates.data( );
+
+        return true;
+    }
+
+    // Write the graph in the format read by Open
+    bool Write( const char *FileName ) const
+    {
+        FILE *file = fopen( FileName, "wb" );
+
+        if ( !file )
+        {
+            return false;
+        }
+
+        const std::uint32_t size[3] = { m_NumberNodes, m_Coordinates ? ( std::uint32_t ) HAS_COORDINATES : 0, 0 };
+        const std::size_t offsets = ( std::size_t ) m_NumberNodes + 1;
+
+        bool ret = fwrite( "CSR1", 1, 4, file ) == 4 &&
+                   fwrite( size, sizeof( size ), 1, file ) == 1 &&
+                   fwrite( &m_NumberEdges, sizeof( m_NumberEdges ), 1, file ) == 1 &&
+                   fwrite( m_Offsets, sizeof( std::uint64_t ), offsets, file ) == offsets &&
+                   fwrite( m_Targets, sizeof( std::uint32_t ), m_NumberEdges, file ) == m_NumberEdges &&
+                   fwrite( m_Costs, sizeof( float ), m_NumberEdges, file ) == m_NumberEdges;
+
+        if ( ret && m_Coordinates )
+        {
+            ret = fwrite( m_Coordinates, sizeof( float ), ( std::size_t ) m_NumberNodes * 2, file ) ==
+                  ( std::size_t ) m_NumberNodes * 2;
+        }
+
+        return ( fclose( file ) == 0 ) && ret;
+    }
+
+    // Map a graph written with Write, returns false if the file is missing
+    // or is not a valid graph. The offsets and targets are checked once so a
+    // damaged file can not make GraphSearch read outside the arrays.
+    bool Open( const char *FileName )
+    {
+        Close( );
+
+        if ( !m_File.Open( FileName ))
+        {
+            return false;
+        }
+
+        const unsigned char *data = m_File.GetData( );
+        const std::size_t dataSize = m_File.GetSize( );
+
+        // Keeps the offsets aligned on 8 bytes
+        const std::size_t header = 4 + 3 * sizeof( std::uint32_t ) + sizeof( std::uint64_t );
+
+        if ( dataSize < header || memcmp( data, "CSR1", 4 ) != 0 )
+        {
+            Close( );
+            return false;
+        }
+
+        std::uint32_t size[3];
+        std::uint64_t edges;
+
+        memcpy( size, data + 4, sizeof( size ));
+        memcpy( &edges, data + 4 + sizeof( size ), sizeof( edges ));
+
+        // Keeps the sizes below from overflowing
+        if ( edges > dataSize / sizeof( std::uint32_t ))
+        {
+            Close( );
+            return false;
+        }
+
+        const std::size_t targets = header + (( std::size_t ) size[0] + 1 ) * sizeof( std::uint64_t );
+        const std::size_t costs = targets + edges * sizeof( std::uint32_t );
+        const std::size_t coordinates = costs + edges * sizeof( float );
+        const std::size_t end = coordinates +
+                                (( size[1] & HAS_COORDINATES ) ? ( std::size_t ) size[0] * 2 * sizeof( float ) : 0 );
+
+        if ( dataSize < end )
+        {
+            Close( );
+            return false;
+        }
+
+        m_NumberNodes = size[0];
+        m_NumberEdges = edges;
+        m_Offsets = ( const std::uint64_t * ) ( data + header );
+        m_Targets = ( const std::uint32_t * ) ( data + targets );
+        m_Costs = ( const float * ) ( data + costs );
+        m_Coordinates = ( size[1] & HAS_COORDINATES ) ? ( const float * ) ( data + coordinates ) : nullptr;
+
+        if ( !IsValid( ))
+        {
+            Close( );
+            return false;
+        }
+
+        return true;
+    }
+
+    void Close( )
+    {
+        m_File.Close( );
+
+        m_OwnedOffsets.clear( );
+        m_OwnedTargets.clear( );
+        m_OwnedCosts.clear( );
+        m_OwnedCoordinates.clear( );
+
+        Reset( );
+    }
+
+    std::uint32_t GetNumberNodes( ) const
+    { return m_NumberNodes; }
+
+    std::uint64_t GetNumberEdges( ) const
+    { return m_NumberEdges; }
+
+    // The edges leaving Node are GetFirstEdge( Node ) up to GetEndEdge( Node )
+    std::uint64_t GetFirstEdge( std::uint32_t Node ) const
+    { return m_Offsets[Node]; }
+
+    std::uint64_t GetEndEdge( std::uint32_t Node ) const
+    { return m_Offsets[Node + 1]; }
+
+    std::uint32_t GetTarget( std::uint64_t Edge ) const
+    { return m_Targets[Edge]; }
+
+    float GetCost( std::uint64_t Edge ) const
+    { return m_Costs[Edge]; }
+
+    bool HasCoordinates( ) const
+    { return m_Coordinates != nullptr; }
+
+    float GetX( std::uint32_t Node ) const
+    { return m_Coordinates[Node * 2]; }
+
+    float GetY( std::uint32_t Node ) const
+    { return m_Coordinates[( Node * 2 ) + 1]; }
+
+private: // methods
+
+    // The edges of each node follow those of the previous node and every
+    // edge leads to an existing node
+    bool IsValid( ) const
+    {
+        if ( m_Offsets[0] != 0 || m_Offsets[m_NumberNodes] != m_NumberEdges )
+        {
+            return false;
+        }
+
+        for ( std::uint32_t node = 0; node < m_NumberNodes; node++ )
+        {
+            if ( m_Offsets[node] > m_Offsets[node + 1] )
+            {
+                return false;
+            }
+        }
+
+        for ( std::uint64_t edge = 0; edge < m_NumberEdges; edge++ )
+        {
+            if ( m_Targets[edge] >= m_NumberNodes )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void Reset( )
+    {
+        m_NumberNodes = 0;
+        m_NumberEdges = 0;
+        m_Offsets = nullptr;
+        m_Targets = nullptr;
+        m_Costs = nullptr;
+        m_Coordinates = nullptr;
+    }
+};
+
+/**
+ * A* over a Graph. The g values and the parents live in arrays indexed by
+ * node id, sized once for the graph and reused by the next searches. Each
+ * search stamps the nodes it touches with its own generation number, so
+ * nothing is cleared between searches.
+ *
+ * Without a heuristic the straight line distance between the coordinates of
+ * the nodes is used, which never overestimates as long as no edge costs less
+ * than its length. A graph without coordinates is searched with Dijkstra.
+ * Any other heuristic can be given as a function of the node id.
+ */
+class GraphSearch
+{
+
+public:
+
+    enum : std::uint32_t { NO_NODE = 0xFFFFFFFF };
+
+private: // data
+
+    std::vector <float> m_G;
+    std::vector <std::uint32_t> m_Parent;
+
+    // Generation of the search that last reached or closed each node
+    std::vector <std::uint32_t> m_Reached;
+    std::vector <std::uint32_t> m_Closed;
+    std::uint32_t m_Generation;
+
+    typedef std::pair <float, std::uint32_t> Entry;
+    std::vector <Entry> m_OpenList;
+
+    std::vector <std::uint32_t> m_Path;
+    float m_Cost;
+
+    // State
+    SearchState m_State;
+
+    // Counts expansions
+    int m_Steps;
+
+public: // methods
+
+    GraphSearch( )
+    {
+        m_Generation = 0;
+        m_Cost = 0.0f;
+        m_State = SearchState::NOT_INITIALISED;
+        m_Steps = 0;
+    }
+
+    // Search with the straight line heuristic, or Dijkstra without coordinates
+    SearchState ComputePath( const Graph &Map, std::uint32_t Start, std::uint32_t Goal )
+    {
+        if ( !Map.HasCoordinates( ) || Goal >= Map.GetNumberNodes( ))
+        {
+            return ComputePath( Map, Start, Goal, []( std::uint32_t ) { return 0.0f; } );
+        }
+
+        const float goalX = Map.GetX( Goal );
+        const float goalY = Map.GetY( Goal );
+
+        return ComputePath( Map, Start, Goal, [&]( std::uint32_t Node )
+        {
+            const float dx = Map.GetX( Node ) - goalX;
+            const float dy = Map.GetY( Node ) - goalY;
+
+            return std::sqrt(( dx * dx ) + ( dy * dy ));
+        } );
+    }
+
+    // Search with Heuristic( node ) estimating the cost from node to Goal
+    template <class HeuristicFunction>
+    SearchState ComputePath( const Graph &Map, std::uint32_t Start, std::uint32_t Goal, HeuristicFunction Heuristic )
+    {
+        m_Path.clear( );
+        m_OpenList.clear( );
+        m_Cost = 0.0f;
+        m_Steps = 0;
+
+        const std::uint32_t nodes = Map.GetNumberNodes( );
+
+        if ( Start >= nodes || Goal >= nodes )
+        {
+            m_State = SearchState::FAILED;
+            return m_State;
+        }
+
+        Prepare( nodes );
+
+        m_State = SearchState::SEARCHING;
+
+        m_G[Start] = 0.0f;
+        m_Parent[Start] = NO_NODE;
+        m_Reached[Start] = m_Generation;
+
+        Push( Heuristic( Start ), Start );
+
+        while ( !m_OpenList.empty( ))
+        {
+            const Entry entry = m_OpenList.front( );
+            Pop( );
+
+            const std::uint32_t node = entry.second;
+
+            // A cheaper entry of the node was popped before this one
+            if ( m_Closed[node] == m_Generation )
+            {
+                continue;
+            }
+
+            m_Closed[node] = m_Generation;
+
+            if ( node == Goal )
+            {
+                StorePath( Goal );
+
+                m_State = SearchState::SUCCEEDED;
+                return m_State;
+            }
+
+            m_Steps++;
+
+            const float g = m_G[node];
+            const std::uint64_t end = Map.GetEndEdge( node );
+
+            for ( std::uint64_t edge = Map.GetFirstEdge( node ); edge < end; edge++ )
+            {
+                const std::uint32_t target = Map.GetTarget( edge );
+                const float ValueGSuccessor = g + Map.GetCost( edge );
+
+                if ( m_Reached[target] == m_Generation && m_G[target] <= ValueGSuccessor )
+                {
+                    continue;
+                }
+
+                // With a consistent heuristic a closed node is never improved,
+                // an inconsistent one reopens it
+                m_Closed[target] = 0;
+
+                m_G[target] = ValueGSuccessor;
+                m_Parent[target] = node;
+                m_Reached[target] = m_Generation;
+
+                Push( ValueGSuccessor + Heuristic( target ), target );
+            }
+        }
+
+        m_State = SearchState::FAILED;
+        return m_State;
+    }
+
+    SearchState GetSearchState( )
+    { return m_State; }
+
+    unsigned int GetNumberSteps( )
+    { return m_Steps; }
+
+    // Node ids of the path from the start to the goal
+    const std::vector <std::uint32_t> &GetPath( ) const
+    { return m_Path; }
+
+    float GetCost( ) const
+    { return m_Cost; }
+
+private: // methods
+
+    // Size the arrays for the graph and start a new generation
+    void Prepare( std::uint32_t Nodes )
+    {
+        if ( m_G.size( ) < Nodes )
+        {
+            m_G.resize( Nodes );
+            m_Parent.resize( Nodes );
+            m_Reached.resize( Nodes, 0 );
+            m_Closed.resize( Nodes, 0 );
+        }
+
+        m_Generation++;
+
+        // Generation zero means never reached, clear the stamps on wrap around
+        if ( m_Generation == 0 )
+        {
+            std::fill( m_Reached.begin( ), m_Reached.end( ), 0 );
+            std::fill( m_Closed.begin( ), m_Closed.end( ), 0 );
+            m_Generation = 1;
+        }
+    }
+
+    void Push( float f, std::uint32_t Node )
+    {
+        m_OpenList.push_back( Entry( f, Node ));
+        push_heap( m_OpenList.begin( ), m_OpenList.end( ), std::greater <Entry>( ));
+    }
+
+    void Pop( )
+    {
+        pop_heap( m_OpenList.begin( ), m_OpenList.end( ), std::greater <Entry>( ));
+        m_OpenList.pop_back( );
+    }
+
+    void StorePath( std::uint32_t Goal )
+    {
+        m_Cost = m_G[Goal];
+
+        for ( std::uint32_t node = Goal; node != NO_NODE; node = m_Parent[node] )
+        {
+            m_Path.push_back( node );
+        }
+
+        std::reverse( m_Path.begin( ), m_Path.end( ));
+    }
+};
+
+#endif
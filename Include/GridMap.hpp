@@ -0,0 +1,355 @@
+/*
+ * Versioned grid map with copy-on-write tiles
+ *
+ * Part of the A* Algorithm Implementation using STL, see AStar.hpp for
+ * copyright and license information.
+ *
+ */
+
+#ifndef GRID_MAP_HPP
+#define GRID_MAP_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A grid of terrain values that can be edited while searches read it.
+ *
+ * Readers pin the current Snapshot and read it without any lock for as long
+ * as they hold it, every search on a pinned snapshot sees one consistent
+ * map. A writer applies a batch of cell edits by copying only the tiles it
+ * touches, the other tiles are shared with the previous snapshot, then
+ * publishes the new snapshot with a single atomic store.
+ *
+ * Old snapshots are freed with epoch based reclamation. A reader announces
+ * the epoch it started in, and a snapshot replaced in epoch E is only freed
+ * once no reader announced an epoch at or before E. Readers never wait for
+ * writers and writers never wait for readers, writers only wait for each
+ * other.
+ */
+class GridMap
+{
+
+public:
+
+    // Width and height of a tile in cells
+    enum : int { TILE_SHIFT = 4, TILE_SIZE = 1 << TILE_SHIFT };
+
+    // Number of readers that can hold a snapshot at the same time
+    enum : int { MAX_READERS = 64 };
+
+    class Tile
+    {
+
+    public:
+
+        int cells[TILE_SIZE * TILE_SIZE];
+    };
+
+    // One version of the map, never modified once published
+    class Snapshot
+    {
+
+    public:
+
+        // Terrain value of the cell, the outside value beyond the map
+        int GetCell( int x, int y ) const
+        {
+            if ( x < 0 || x >= m_Width || y < 0 || y >= m_Height )
+            {
+                return m_Outside;
+            }
+
+            const Tile &tile = *m_Tiles[(( y >> TILE_SHIFT ) * m_TilesX ) + ( x >> TILE_SHIFT )];
+
+            return tile.cells[(( y & ( TILE_SIZE - 1 )) * TILE_SIZE ) + ( x & ( TILE_SIZE - 1 ))];
+        }
+
+        int GetWidth( ) const
+        { return m_Width; }
+
+        int GetHeight( ) const
+        { return m_Height; }
+
+        std::uint64_t GetVersion( ) const
+        { return m_Version; }
+
+    private:
+
+        friend class GridMap;
+
+        int m_Width;
+        int m_Height;
+        int m_TilesX;
+        int m_Outside;
+        std::uint64_t m_Version;
+
+        // Tiles shared with the snapshots that did not edit them
+        std::vector <std::shared_ptr <Tile>> m_Tiles;
+    };
+
+    class Edit
+    {
+
+    public:
+
+        int x;
+        int y;
+        int value;
+
+        Edit( int X, int Y, int Value )
+        {
+            x = X;
+            y = Y;
+            value = Value;
+        }
+    };
+
+    /**
+     * Pins the current snapshot of a map for the lifetime of the guard, the
+     * snapshot stays valid even if writers publish newer ones meanwhile.
+     */
+    class ReadGuard
+    {
+
+    public:
+
+        explicit ReadGuard( GridMap &Map )
+        {
+            m_Map = &Map;
+            m_Slot = Map.Pin( m_Snapshot );
+        }
+
+        ~ReadGuard( )
+        {
+            m_Map->Unpin( m_Slot );
+        }
+
+        ReadGuard( const ReadGuard & ) = delete;
+        ReadGuard &operator=( const ReadGuard & ) = delete;
+
+        const Snapshot *Get( ) const
+        { return m_Snapshot; }
+
+        const Snapshot *operator->( ) const
+        { return m_Snapshot; }
+
+    private:
+
+        GridMap *m_Map;
+        const Snapshot *m_Snapshot;
+        int m_Slot;
+    };
+
+private: // data
+
+    // Epoch announced by each reader, zero when the slot is free. Each slot
+    // has its own cache line so readers do not slow each other down.
+    class alignas( 64 ) ReaderSlot
+    {
+
+    public:
+
+        std::atomic <std::uint64_t> epoch;
+
+        ReaderSlot( ) : epoch( 0 )
+        { }
+    };
+
+    class Retired
+    {
+
+    public:
+
+        Snapshot *snapshot;
+        std::uint64_t epoch;
+    };
+
+    std::atomic <Snapshot *> m_Current;
+    std::atomic <std::uint64_t> m_Epoch;
+
+    // Version of m_Current, kept apart so it can be read without pinning
+    std::atomic <std::uint64_t> m_Version;
+
+    ReaderSlot m_Readers[MAX_READERS];
+
+    // Writers only
+    std::mutex m_WriteMutex;
+    std::vector <Retired> m_Retired;
+
+public: // methods
+
+    // Cells holds Width * Height terrain values row after row, Outside is the
+    // value of the cells beyond the map
+    GridMap( int Width, int Height, const int *Cells, int Outside = 9 )
+    {
+        Snapshot *snapshot = new Snapshot( );
+
+        snapshot->m_Width = Width;
+        snapshot->m_Height = Height;
+        snapshot->m_TilesX = ( Width + TILE_SIZE - 1 ) / TILE_SIZE;
+        snapshot->m_Outside = Outside;
+        snapshot->m_Version = 0;
+
+        const int tilesY = ( Height + TILE_SIZE - 1 ) / TILE_SIZE;
+
+        for ( int ty = 0; ty < tilesY; ty++ )
+        {
+            for ( int tx = 0; tx < snapshot->m_TilesX; tx++ )
+            {
+                std::shared_ptr <Tile> tile = std::make_shared <Tile>( );
+
+                for ( int y = 0; y < TILE_SIZE; y++ )
+                {
+                    for ( int x = 0; x < TILE_SIZE; x++ )
+                    {
+                        int cellX = ( tx * TILE_SIZE ) + x;
+                        int cellY = ( ty * TILE_SIZE ) + y;
+
+                        tile->cells[( y * TILE_SIZE ) + x] = ( cellX < Width && cellY < Height ) ?
+                                                             Cells[( cellY * Width ) + cellX] : Outside;
+                    }
+                }
+
+                snapshot->m_Tiles.push_back( tile );
+            }
+        }
+
+        m_Current.store( snapshot );
+        m_Epoch.store( 1 );
+        m_Version.store( 0 );
+    }
+
+    // No reader may hold a snapshot any more
+    ~GridMap( )
+    {
+        for ( Retired &retired: m_Retired )
+        {
+            delete retired.snapshot;
+        }
+
+        delete m_Current.load( );
+    }
+
+    GridMap( const GridMap & ) = delete;
+    GridMap &operator=( const GridMap & ) = delete;
+
+    // Apply a batch of edits and publish them as a new snapshot. Only the
+    // tiles holding edited cells are copied. Returns the new version.
+    std::uint64_t Apply( const std::vector <Edit> &Edits )
+    {
+        std::lock_guard <std::mutex> lock( m_WriteMutex );
+
+        Snapshot *previous = m_Current.load( );
+        Snapshot *snapshot = new Snapshot( *previous );
+
+        snapshot->m_Version = previous->m_Version + 1;
+
+        for ( const Edit &edit: Edits )
+        {
+            if ( edit.x < 0 || edit.x >= snapshot->m_Width || edit.y < 0 || edit.y >= snapshot->m_Height )
+            {
+                continue;
+            }
+
+            const int index = (( edit.y >> TILE_SHIFT ) * snapshot->m_TilesX ) + ( edit.x >> TILE_SHIFT );
+            std::shared_ptr <Tile> &tile = snapshot->m_Tiles[index];
+
+            // Still shared with the previous snapshot, copy before writing
+            if ( tile == previous->m_Tiles[index] )
+            {
+                tile = std::make_shared <Tile>( *tile );
+            }
+
+            tile->cells[(( edit.y & ( TILE_SIZE - 1 )) * TILE_SIZE ) + ( edit.x & ( TILE_SIZE - 1 ))] = edit.value;
+        }
+
+        m_Current.store( snapshot );
+        m_Version.store( snapshot->m_Version );
+
+        // Readers that announce a later epoch can only see the new snapshot
+        Retired retired;
+        retired.snapshot = previous;
+        retired.epoch = m_Epoch.fetch_add( 1 );
+        m_Retired.push_back( retired );
+
+        const std::uint64_t version = snapshot->m_Version;
+
+        Reclaim( );
+
+        return version;
+    }
+
+    // Version of the latest published snapshot. The snapshot itself may be
+    // replaced and freed at any time, use a ReadGuard to read it.
+    std::uint64_t GetVersion( ) const
+    {
+        return m_Version.load( );
+    }
+
+private: // methods
+
+    int Pin( const Snapshot *&Pinned )
+    {
+        for ( int slot = 0; ; slot = ( slot + 1 ) % MAX_READERS )
+        {
+            std::uint64_t free = 0;
+
+            if ( m_Readers[slot].epoch.load( std::memory_order_relaxed ) == 0 &&
+                 m_Readers[slot].epoch.compare_exchange_strong( free, m_Epoch.load( )))
+            {
+                Pinned = m_Current.load( );
+                return slot;
+            }
+
+            // Only when more than MAX_READERS readers pin at the same time
+            if ( slot == MAX_READERS - 1 )
+            {
+                std::this_thread::yield( );
+            }
+        }
+    }
+
+    void Unpin( int Slot )
+    {
+        m_Readers[Slot].epoch.store( 0, std::memory_order_release );
+    }
+
+    // Free the snapshots no reader can still hold
+    void Reclaim( )
+    {
+        std::uint64_t oldest = UINT64_MAX;
+
+        for ( ReaderSlot &reader: m_Readers )
+        {
+            std::uint64_t epoch = reader.epoch.load( );
+
+            if ( epoch != 0 && epoch < oldest )
+            {
+                oldest = epoch;
+            }
+        }
+
+        std::size_t kept = 0;
+
+        for ( Retired &retired: m_Retired )
+        {
+            if ( retired.epoch < oldest )
+            {
+                delete retired.snapshot;
+            }
+            else
+            {
+                m_Retired[kept++] = retired;
+            }
+        }
+
+        m_Retired.resize( kept );
+    }
+};
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Read only file mapped in memory
+ *
+ * Part of the A* Algorithm Implementation using STL, see AStar.hpp for
+ * copyright and license information.
+ *
+ */
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+#if !defined( _WIN32 )
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * The contents of a file mapped in memory with mmap, so large tables load
+ * without being read or parsed. Where mmap is not available the file is read
+ * into a buffer instead. Used by PathDatabase and Graph.
+ */
+class MappedFile
+{
+
+private: // data
+
+    // Mapped file, or a copy of it where mmap is not available
+    const unsigned char *m_Data;
+    std::size_t m_Size;
+    std::vector <unsigned char> m_Buffer;
+
+public: // methods
+
+    MappedFile( )
+    {
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+
+    ~MappedFile( )
+    {
+        Close( );
+    }
+
+    MappedFile( const MappedFile & ) = delete;
+    MappedFile &operator=( const MappedFile & ) = delete;
+
+    // Returns false if the file is missing or empty
+    bool Open( const char *FileName )
+    {
+        Close( );
+
+#if !defined( _WIN32 )
+        int descriptor = open( FileName, O_RDONLY );
+
+        if ( descriptor < 0 )
+        {
+            return false;
+        }
+
+        struct stat status;
+
+        if ( fstat( descriptor, &status ) != 0 || status.st_size == 0 )
+        {
+            close( descriptor );
+            return false;
+        }
+
+        void *data = mmap( nullptr, ( std::size_t ) status.st_size, PROT_READ, MAP_SHARED, descriptor, 0 );
+        close( descriptor );
+
+        if ( data == MAP_FAILED )
+        {
+            return false;
+        }
+
+        m_Data = ( const unsigned char * ) data;
+        m_Size = ( std::size_t ) status.st_size;
+#else
+        FILE *file = fopen( FileName, "rb" );
+
+        if ( !file )
+        {
+            return false;
+        }
+
+        unsigned char chunk[4096];
+        std::size_t count;
+
+        while (( count = fread( chunk, 1, sizeof( chunk ), file )) > 0 )
+        {
+            m_Buffer.insert( m_Buffer.end( ), chunk, chunk + count );
+        }
+
+        fclose( file );
+
+        if ( m_Buffer.empty( ))
+        {
+            return false;
+        }
+
+        m_Data = m_Buffer.data( );
+        m_Size = m_Buffer.size( );
+#endif
+
+        return true;
+    }
+
+    void Close( )
+    {
+#if !defined( _WIN32 )
+        if ( m_Data )
+        {
+            munmap(( void * ) m_Data, m_Size );
+        }
+#endif
+
+        m_Buffer.clear( );
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+
+    const unsigned char *GetData( ) const
+    { return m_Data; }
+
+    std::size_t GetSize( ) const
+    { return m_Size; }
+};
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ * Hash finaliser shared by the hash tables of the searches
+ *
+ * Part of the A* Algorithm Implementation using STL, see AStar.hpp for
+ * copyright and license information.
+ *
+ */
+
+#ifndef MIX_HASH_HPP
+#define MIX_HASH_HPP
+
+#include <cstdint>
+
+/**
+ * splitmix64 finaliser. Hashes of neighbouring cells often differ in a few
+ * low bits only, mixing spreads them over every bit so they can be reduced
+ * to a table slot or a thread with a mask or a modulo. Used by AStar,
+ * ParallelAStar and ReservationTable.
+ */
+inline std::uint64_t MixHash( std::uint64_t Key )
+{
+    Key ^= Key >> 30;
+    Key *= 0xBF58476D1CE4E5B9ULL;
+    Key ^= Key >> 27;
+    Key *= 0x94D049BB133111EBULL;
+    Key ^= Key >> 31;
+
+    return Key;
+}
+
+#endif
@@ -0,0 +1,574 @@
+/*
+ * Hash distributed A* (HDA*) implementation using STL
+ *
+ * Part of the A* Algorithm Implementation using STL, see AStar.hpp for
+ * copyright and license information.
+ *
+ */
+
+#ifndef PARALLEL_ASTAR_HPP
+#define PARALLEL_ASTAR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "AStar.hpp"
+#include "MixHash.hpp"
+
+/**
+ * Runs a single A* search on several threads (Kishimoto, Fukunaga and Botea,
+ * 2009). Every state is owned by the thread its hash maps to, and only that
+ * thread keeps its g value, its open list entry and its closed status. A
+ * thread expanding a node sends each successor to the owner of the successor
+ * through the owner's lock-free inbox, so threads never share a lock while
+ * searching.
+ *
+ * Finding a goal does not end the search straight away, a cheaper goal may
+ * still be on the way through another thread. The cost of the best goal
+ * found so far prunes every node with an f at or above it, and the search
+ * ends once every thread has run out of nodes below it and no message is in
+ * flight, so the path returned is optimal like the one of AStar.
+ *
+ * The UserState is the same as for AStar with one more function, Hash( ),
+ * which returns the same value for any two states that are IsSameState.
+ */
+template <class UserState> class ParallelAStar
+{
+
+public:
+
+    class Node
+    {
+
+    public:
+
+        Node *parent; // owned by the thread that expanded it
+
+        float g; // cost of this node + it's predecessors
+        float h; // heuristic estimate of distance to goal
+
+        Node()
+        {
+            parent = nullptr;
+            g = 0.0f;
+            h = 0.0f;
+        }
+
+        UserState m_UserState;
+    };
+
+private: // classes
+
+    // A successor on its way to the thread owning its state
+    class Message
+    {
+
+    public:
+
+        std::atomic <Message *> next;
+
+        UserState m_UserState;
+        float g;
+        Node *parent;
+
+        Message( ) : next( nullptr )
+        {
+            g = 0.0f;
+            parent = nullptr;
+        }
+    };
+
+    /**
+     * Intrusive multiple producer single consumer queue (Dmitry Vyukov).
+     * Pushing is one atomic exchange. Pop may miss a message whose push is
+     * still in progress, it is picked up by a later Pop.
+     */
+    class MessageQueue
+    {
+
+    public:
+
+        MessageQueue( )
+        {
+            m_Head.store( &m_Stub );
+            m_Tail = &m_Stub;
+        }
+
+        void Push( Message *message )
+        {
+            message->next.store( nullptr, std::memory_order_relaxed );
+            Message *previous = m_Head.exchange( message, std::memory_order_acq_rel );
+            previous->next.store( message, std::memory_order_release );
+        }
+
+        // Consumer only
+        Message *Pop( )
+        {
+            Message *tail = m_Tail;
+            Message *next = tail->next.load( std::memory_order_acquire );
+
+            if ( tail == &m_Stub )
+            {
+                if ( !next )
+                {
+                    return nullptr;
+                }
+
+                m_Tail = next;
+                tail = next;
+                next = next->next.load( std::memory_order_acquire );
+            }
+
+            if ( next )
+            {
+                m_Tail = next;
+                return tail;
+            }
+
+            if ( tail != m_Head.load( std::memory_order_acquire ))
+            {
+                return nullptr;
+            }
+
+            Push( &m_Stub );
+            next = tail->next.load( std::memory_order_acquire );
+
+            if ( next )
+            {
+                m_Tail = next;
+                return tail;
+            }
+
+            return nullptr;
+        }
+
+    private:
+
+        std::atomic <Message *> m_Head;
+        Message *m_Tail;
+        Message m_Stub;
+    };
+
+    class OpenEntry
+    {
+
+    public:
+
+        float f;
+        float g; // g of the node when pushed, entries of improved nodes are stale
+        Node *node;
+    };
+
+    class OpenCompare
+    {
+
+    public:
+
+        bool operator() ( const OpenEntry &x, const OpenEntry &y ) const
+        {
+            return x.f > y.f;
+        }
+    };
+
+public: // classes
+
+    // The part of the search run by one thread, also what GetSuccessors
+    // receives to call AddSuccessor on
+    class Worker
+    {
+
+    public:
+
+        // User calls this to add a successor to a list of successors
+        // when expanding the search frontier
+        bool AddSuccessor( UserState &State )
+        {
+            m_Successors.push_back( State );
+            return true;
+        }
+
+    private:
+
+        friend class ParallelAStar;
+
+        ParallelAStar *m_Search;
+        int m_Index;
+
+        MessageQueue m_Inbox;
+
+        vector< OpenEntry > m_OpenList;
+
+        // Nodes owned by this thread by state hash
+        unordered_multimap< size_t, Node * > m_Nodes;
+
+        vector< UserState > m_Successors;
+
+        // Messages received since the thread last went idle
+        int m_Received;
+
+        int m_Steps;
+    };
+
+private: // data
+
+    unsigned int m_NumberThreads;
+
+    vector< Worker * > m_Workers;
+
+    // Messages sent and not yet accounted for by an idle receiver
+    std::atomic <long long> m_InFlight;
+
+    std::atomic <int> m_Idle;
+    std::atomic <bool> m_Done;
+
+    // Cost of the best goal found so far, prunes the search
+    std::atomic <float> m_BestCost;
+
+    std::mutex m_GoalMutex;
+    Node *m_BestGoal;
+
+    UserState m_Goal;
+
+    queue <Point2D> m_Points;
+
+    // State
+    SearchState m_State;
+
+    // Counts expansions over all the threads
+    int m_Steps;
+
+public: // methods
+
+    // Threads defaults to the number of cores
+    explicit ParallelAStar( unsigned int Threads = 0 )
+    {
+        if ( Threads == 0 )
+        {
+            Threads = std::max( 1u, std::thread::hardware_concurrency( ));
+        }
+
+        m_NumberThreads = Threads;
+        m_BestGoal = nullptr;
+        m_State = SearchState::NOT_INITIALISED;
+        m_Steps = 0;
+    }
+
+    ~ParallelAStar( )
+    {
+        FreeAllNodes( );
+    }
+
+    ParallelAStar( const ParallelAStar & ) = delete;
+    ParallelAStar &operator=( const ParallelAStar & ) = delete;
+
+    SearchState ComputePath( UserState Start, UserState Goal )
+    {
+        FreeAllNodes( );
+
+        while ( !m_Points.empty( ))
+        { m_Points.pop( ); }
+
+        m_Goal = Goal;
+        m_BestGoal = nullptr;
+        m_BestCost = FLT_MAX;
+        m_Idle = 0;
+        m_Done = false;
+        m_InFlight = 0;
+        m_State = SearchState::SEARCHING;
+
+        for ( unsigned int i = 0; i < m_NumberThreads; i++ )
+        {
+            Worker *worker = new Worker( );
+
+            worker->m_Search = this;
+            worker->m_Index = ( int ) i;
+            worker->m_Received = 0;
+            worker->m_Steps = 0;
+
+            m_Workers.push_back( worker );
+        }
+
+        // The start state is the first message
+        Send( Start, 0.0f, nullptr );
+
+        vector< std::thread > threads;
+
+        for ( unsigned int i = 1; i < m_NumberThreads; i++ )
+        {
+            threads.emplace_back( &ParallelAStar::Run, this, m_Workers[i] );
+        }
+
+        Run( m_Workers[0] );
+
+        for ( std::thread &thread: threads )
+        {
+            thread.join( );
+        }
+
+        m_Steps = 0;
+
+        for ( Worker *worker: m_Workers )
+        {
+            m_Steps += worker->m_Steps;
+        }
+
+        if ( !m_BestGoal )
+        {
+            FreeAllNodes( );
+
+            m_State = SearchState::FAILED;
+            return m_State;
+        }
+
+        // Store the path from start to goal, all the threads are done so the
+        // parent pointers can be followed across threads
+
+        vector< Node * > path;
+
+        for ( Node *node = m_BestGoal; node; node = node->parent )
+        {
+            path.push_back( node );
+        }
+
+        for ( auto node = path.rbegin( ); node != path.rend( ); node++ )
+        {
+            m_Points.push( Point2D(( *node )->m_UserState.x, ( *node )->m_UserState.y ));
+        }
+
+        FreeAllNodes( );
+
+        m_State = SearchState::SUCCEEDED;
+        return m_State;
+    }
+
+    // The nodes are freed as soon as the path is stored, kept so that
+    // ParallelAStar can be used where AStar is
+    void FreeSolutionNodes( )
+    { }
+
+    SearchState GetSearchState( )
+    { return m_State; }
+
+    unsigned int GetNumberSteps( )
+    { return m_Steps; }
+
+    unsigned int GetNumberThreads( )
+    { return m_NumberThreads; }
+
+    // Functions for traversing the solution
+
+    Point2D Walk( )
+    {
+        Point2D point = m_Points.front( );
+        m_Points.pop( );
+
+        return point;
+    }
+
+    unsigned int GetSizePath( )
+    {
+        return m_Points.size( );
+    }
+
+private: // methods
+
+    Worker *GetOwner( UserState &State )
+    {
+        return m_Workers[MixHash( State.Hash( )) % m_NumberThreads];
+    }
+
+    void Send( UserState &State, float g, Node *Parent )
+    {
+        Message *message = new Message( );
+
+        message->m_UserState = State;
+        message->g = g;
+        message->parent = Parent;
+
+        m_InFlight.fetch_add( 1 );
+        GetOwner( State )->m_Inbox.Push( message );
+    }
+
+    // Add a state reached with cost g to the nodes of its owner, unless the
+    // owner already knows a path at least as cheap
+    void Receive( Worker *Owner, UserState &State, float g, Node *Parent )
+    {
+        size_t hash = State.Hash( );
+        Node *node = nullptr;
+
+        auto range = Owner->m_Nodes.equal_range( hash );
+
+        for ( auto iter = range.first; iter != range.second; iter++ )
+        {
+            if ( iter->second->m_UserState.IsSameState( State ))
+            {
+                node = iter->second;
+                break;
+            }
+        }
+
+        if ( node )
+        {
+            if ( node->g <= g )
+            {
+                return;
+            }
+        }
+        else
+        {
+            node = new Node( );
+            node->m_UserState = State;
+            node->h = State.GoalDistanceEstimate( m_Goal );
+
+            Owner->m_Nodes.insert( make_pair( hash, node ));
+        }
+
+        // Open or closed, the node goes (back) on the open list
+        node->g = g;
+        node->parent = Parent;
+
+        OpenEntry entry;
+        entry.f = g + node->h;
+        entry.g = g;
+        entry.node = node;
+
+        Owner->m_OpenList.push_back( entry );
+        push_heap( Owner->m_OpenList.begin( ), Owner->m_OpenList.end( ), OpenCompare( ));
+    }
+
+    void Run( Worker *worker )
+    {
+        bool idle = false;
+
+        while ( !m_Done.load( std::memory_order_acquire ))
+        {
+            // Take in the successors sent by the other threads
+
+            while ( Message *message = worker->m_Inbox.Pop( ))
+            {
+                if ( idle )
+                {
+                    idle = false;
+                    m_Idle.fetch_sub( 1 );
+                }
+
+                worker->m_Received++;
+                Receive( worker, message->m_UserState, message->g, message->parent );
+                delete message;
+            }
+
+            // Expand the best node below the cost of the best goal
+
+            bool expanded = false;
+
+            while ( !worker->m_OpenList.empty( ))
+            {
+                OpenEntry entry = worker->m_OpenList.front( );
+
+                if ( entry.f >= m_BestCost.load( std::memory_order_relaxed ))
+                {
+                    break;
+                }
+
+                pop_heap( worker->m_OpenList.begin( ), worker->m_OpenList.end( ), OpenCompare( ));
+                worker->m_OpenList.pop_back( );
+
+                // A cheaper path to the node was found after this entry was pushed
+                if ( entry.g != entry.node->g )
+                {
+                    continue;
+                }
+
+                Expand( worker, entry.node );
+                expanded = true;
+                break;
+            }
+
+            if ( expanded )
+            {
+                continue;
+            }
+
+            // Nothing left to do below the best goal, the messages received
+            // are accounted for only now so a thread is never seen idle
+            // while the work they brought in is still pending
+
+            if ( !idle )
+            {
+                idle = true;
+                m_Idle.fetch_add( 1 );
+                m_InFlight.fetch_sub( worker->m_Received );
+                worker->m_Received = 0;
+            }
+
+            if ( m_Idle.load( ) == ( int ) m_NumberThreads && m_InFlight.load( ) == 0 )
+            {
+                m_Done.store( true, std::memory_order_release );
+                break;
+            }
+
+            std::this_thread::yield( );
+        }
+    }
+
+    void Expand( Worker *worker, Node *n )
+    {
+        worker->m_Steps++;
+
+        if ( n->m_UserState.IsGoal( m_Goal ))
+        {
+            std::lock_guard <std::mutex> lock( m_GoalMutex );
+
+            if ( n->g < m_BestCost.load( ))
+            {
+                m_BestCost.store( n->g );
+                m_BestGoal = n;
+            }
+
+            return;
+        }
+
+        worker->m_Successors.clear( );
+        n->m_UserState.GetSuccessors( worker, n->parent ? &n->parent->m_UserState : nullptr );
+
+        for ( UserState &state: worker->m_Successors )
+        {
+            float ValueGSuccessor = n->g + n->m_UserState.GetCost( state );
+
+            if ( GetOwner( state ) == worker )
+            {
+                Receive( worker, state, ValueGSuccessor, n );
+            }
+            else
+            {
+                Send( state, ValueGSuccessor, n );
+            }
+        }
+    }
+
+    void FreeAllNodes( )
+    {
+        for ( Worker *worker: m_Workers )
+        {
+            for ( auto &node: worker->m_Nodes )
+            {
+                delete node.second;
+            }
+
+            // Messages can only be left over if the search was pruned
+            while ( Message *message = worker->m_Inbox.Pop( ))
+            {
+                delete message;
+            }
+
+            delete worker;
+        }
+
+        m_Workers.clear( );
+    }
+};
+
+#endif
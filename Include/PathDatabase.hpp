@@ -0,0 +1,434 @@
+/*
+ * Compressed path database for static grid maps
+ *
+ * Part of the A* Algorithm Implementation using STL, see AStar.hpp for
+ * copyright and license information.
+ *
+ */
+
+#ifndef PATH_DATABASE_HPP
+#define PATH_DATABASE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "AStar.hpp"
+#include "MappedFile.hpp"
+
+/**
+ * A path database stores, for every source cell of a map that never changes,
+ * the first move of an optimal path to every target cell. A query follows the
+ * first moves from the start to the goal, so it costs one table lookup per
+ * step of the path and no search at all.
+ *
+ * The tables are built offline with one Dijkstra search per source, spread
+ * over all the cores. The first moves of a source are stored as runs of
+ * targets sharing the same move, a run never crosses the end of a row of the
+ * map. The database file is mapped in memory when it is opened.
+ *
+ * File layout, all values in the byte order of the machine that built it:
+ *
+ *   char     magic[4]        "CPD1"
+ *   uint32   width, height, reserved
+ *   uint64   offsets[width * height + 1]  first run of each source
+ *   uint32   runs[]          (first target of the run << 3) | move
+ */
+class PathDatabase
+{
+
+public:
+
+    enum Move : std::uint8_t
+    {
+        MOVE_NONE, // the target is the source or it can not be reached
+        MOVE_LEFT,
+        MOVE_RIGHT,
+        MOVE_UP,
+        MOVE_DOWN
+    };
+
+private: // data
+
+    MappedFile m_File;
+
+    int m_Width;
+    int m_Height;
+
+    const std::uint64_t *m_Offsets;
+    const std::uint32_t *m_Runs;
+
+    queue <Point2D> m_Points;
+
+    // State
+    SearchState m_State;
+
+    // Counts table lookups
+    int m_Steps;
+
+public: // methods
+
+    PathDatabase( )
+    {
+        m_Width = 0;
+        m_Height = 0;
+        m_Offsets = nullptr;
+        m_Runs = nullptr;
+        m_State = SearchState::NOT_INITIALISED;
+        m_Steps = 0;
+    }
+
+    ~PathDatabase( )
+    {
+        Close( );
+    }
+
+    PathDatabase( const PathDatabase & ) = delete;
+    PathDatabase &operator=( const PathDatabase & ) = delete;
+
+    // Build the database of a map and write it to a file. Terrain takes
+    // (x, y) and returns the cost of moving into the cell in the scale of the
+    // sample GetMap, 9 meaning the cell can not be passed. Threads defaults to
+    // the number of cores. Returns false if the file can not be written.
+    template <class TerrainFunction>
+    static bool Build( int Width, int Height, TerrainFunction Terrain, const char *FileName,
+                       unsigned int Threads = 0 )
+    {
+        const int cells = Width * Height;
+
+        std::vector <int> costs( cells );
+
+        for ( int y = 0; y < Height; y++ )
+        {
+            for ( int x = 0; x < Width; x++ )
+            {
+                costs[( y * Width ) + x] = Terrain( x, y );
+            }
+        }
+
+        if ( Threads == 0 )
+        {
+            Threads = std::max( 1u, std::thread::hardware_concurrency( ));
+        }
+
+        std::vector <std::vector <std::uint32_t>> runs( cells );
+        std::atomic <int> nextSource( 0 );
+
+        auto worker = [&]( )
+        {
+            std::vector <float> distance( cells );
+            std::vector <std::uint8_t> firstMove( cells );
+
+            for ( int source = nextSource++; source < cells; source = nextSource++ )
+            {
+                ComputeFirstMoves( source, Width, Height, costs, distance, firstMove );
+                CompressFirstMoves( Width, cells, firstMove, runs[source] );
+            }
+        };
+
+        std::vector <std::thread> workers;
+
+        for ( unsigned int i = 1; i < Threads; i++ )
+        {
+            workers.emplace_back( worker );
+        }
+
+        worker( );
+
+        for ( std::thread &thread : workers )
+        {
+            thread.join( );
+        }
+
+        // Write out the header, the offsets and the runs
+
+        FILE *file = fopen( FileName, "wb" );
+
+        if ( !file )
+        {
+            return false;
+        }
+
+        std::uint32_t size[3] = {( std::uint32_t ) Width, ( std::uint32_t ) Height, 0 };
+        std::vector <std::uint64_t> offsets( cells + 1 );
+
+        offsets[0] = 0;
+
+        for ( int source = 0; source < cells; source++ )
+        {
+            offsets[source + 1] = offsets[source] + runs[source].size( );
+        }
+
+        bool ret = fwrite( "CPD1", 1, 4, file ) == 4 &&
+                   fwrite( size, sizeof( size ), 1, file ) == 1 &&
+                   fwrite( offsets.data( ), sizeof( std::uint64_t ), offsets.size( ), file ) == offsets.size( );
+
+        for ( int source = 0; ret && source < cells; source++ )
+        {
+            ret = fwrite( runs[source].data( ), sizeof( std::uint32_t ), runs[source].size( ), file ) ==
+                  runs[source].size( );
+        }
+
+        return ( fclose( file ) == 0 ) && ret;
+    }
+
+    // Map a database built with Build, returns false if the file is missing
+    // or is not a path database
+    bool Open( const char *FileName )
+    {
+        Close( );
+
+        if ( !m_File.Open( FileName ))
+        {
+            return false;
+        }
+
+        const unsigned char *data = m_File.GetData( );
+        const std::size_t dataSize = m_File.GetSize( );
+
+        // Keeps the offsets aligned on 8 bytes
+        const std::size_t header = 4 + 3 * sizeof( std::uint32_t );
+
+        if ( dataSize < header || memcmp( data, "CPD1", 4 ) != 0 )
+        {
+            Close( );
+            return false;
+        }
+
+        std::uint32_t size[3];
+        memcpy( size, data + 4, sizeof( size ));
+
+        const std::size_t cells = ( std::size_t ) size[0] * size[1];
+        const std::size_t runs = header + ( cells + 1 ) * sizeof( std::uint64_t );
+
+        if ( dataSize < runs )
+        {
+            Close( );
+            return false;
+        }
+
+        m_Width = ( int ) size[0];
+        m_Height = ( int ) size[1];
+        m_Offsets = ( const std::uint64_t * ) ( data + header );
+        m_Runs = ( const std::uint32_t * ) ( data + runs );
+
+        if ( dataSize < runs + m_Offsets[cells] * sizeof( std::uint32_t ))
+        {
+            Close( );
+            return false;
+        }
+
+        return true;
+    }
+
+    void Close( )
+    {
+        m_File.Close( );
+        m_Offsets = nullptr;
+        m_Runs = nullptr;
+        m_Width = 0;
+        m_Height = 0;
+    }
+
+    // Follow the first moves from Start to Goal. Like AStar the path is read
+    // back with Walk and GetSizePath. The user state only needs x and y.
+    template <class UserState>
+    SearchState ComputePath( UserState Start, UserState Goal )
+    {
+        while ( !m_Points.empty( ))
+        { m_Points.pop( ); }
+
+        m_Steps = 0;
+
+        if ( !m_Offsets || !IsInside( Start.x, Start.y ) || !IsInside( Goal.x, Goal.y ))
+        {
+            m_State = SearchState::FAILED;
+            return m_State;
+        }
+
+        const int goal = ( Goal.y * m_Width ) + Goal.x;
+
+        int x = Start.x;
+        int y = Start.y;
+
+        m_Points.push( Point2D( x, y ));
+
+        // An optimal path never visits a cell twice
+        while ( x != Goal.x || y != Goal.y )
+        {
+            m_Steps++;
+
+            if ( m_Steps > m_Width * m_Height )
+            {
+                m_State = SearchState::FAILED;
+                return m_State;
+            }
+
+            switch ( GetFirstMove(( y * m_Width ) + x, goal ))
+            {
+                case MOVE_LEFT: x -= 1; break;
+                case MOVE_RIGHT: x += 1; break;
+                case MOVE_UP: y -= 1; break;
+                case MOVE_DOWN: y += 1; break;
+
+                default:
+                    while ( !m_Points.empty( ))
+                    { m_Points.pop( ); }
+
+                    m_State = SearchState::FAILED;
+                    return m_State;
+            }
+
+            m_Points.push( Point2D( x, y ));
+        }
+
+        m_State = SearchState::SUCCEEDED;
+        return m_State;
+    }
+
+    // First move of an optimal path from the source cell to the target cell,
+    // both given as y * width + x
+    Move GetFirstMove( int Source, int Target ) const
+    {
+        const std::uint32_t *begin = m_Runs + m_Offsets[Source];
+        const std::uint32_t *end = m_Runs + m_Offsets[Source + 1];
+
+        // The run holding the target is the last one starting at or before it
+        const std::uint32_t key = (( std::uint32_t ) Target << 3 ) | 7;
+        const std::uint32_t *run = std::upper_bound( begin, end, key );
+
+        if ( run == begin )
+        {
+            return MOVE_NONE;
+        }
+
+        return ( Move ) ( *( run - 1 ) & 7 );
+    }
+
+    SearchState GetSearchState( )
+    { return m_State; }
+
+    unsigned int GetNumberSteps( )
+    { return m_Steps; }
+
+    Point2D Walk( )
+    {
+        Point2D point = m_Points.front( );
+        m_Points.pop( );
+
+        return point;
+    }
+
+    unsigned int GetSizePath( )
+    {
+        return m_Points.size( );
+    }
+
+    int GetWidth( ) const
+    { return m_Width; }
+
+    int GetHeight( ) const
+    { return m_Height; }
+
+    // Number of runs over all the sources, a measure of the compression
+    std::uint64_t GetNumberRuns( ) const
+    {
+        return m_Offsets ? m_Offsets[( std::size_t ) m_Width * m_Height] : 0;
+    }
+
+private: // methods
+
+    bool IsInside( int x, int y ) const
+    {
+        return x >= 0 && x < m_Width && y >= 0 && y < m_Height;
+    }
+
+    // Dijkstra from the source, every cell inherits the first move of the
+    // cell it was reached from
+    static void ComputeFirstMoves( int Source, int Width, int Height, const std::vector <int> &Costs,
+                                   std::vector <float> &Distance, std::vector <std::uint8_t> &FirstMove )
+    {
+        std::fill( Distance.begin( ), Distance.end( ), FLT_MAX );
+        std::fill( FirstMove.begin( ), FirstMove.end( ), ( std::uint8_t ) MOVE_NONE );
+
+        if ( Costs[Source] >= 9 )
+        {
+            return;
+        }
+
+        typedef std::pair <float, int> Entry;
+        std::priority_queue <Entry, std::vector <Entry>, std::greater <Entry>> open;
+
+        Distance[Source] = 0.0f;
+        open.push( Entry( 0.0f, Source ));
+
+        while ( !open.empty( ))
+        {
+            Entry entry = open.top( );
+            open.pop( );
+
+            const int cell = entry.second;
+
+            if ( entry.first > Distance[cell] )
+            {
+                continue;
+            }
+
+            const int x = cell % Width;
+            const int y = cell / Width;
+
+            const int neighbours[4] =
+            {
+                x > 0 ? cell - 1 : -1,
+                x < Width - 1 ? cell + 1 : -1,
+                y > 0 ? cell - Width : -1,
+                y < Height - 1 ? cell + Width : -1
+            };
+
+            for ( int i = 0; i < 4; i++ )
+            {
+                const int next = neighbours[i];
+
+                if ( next < 0 || Costs[next] >= 9 )
+                {
+                    continue;
+                }
+
+                const float distance = Distance[cell] + ( float ) Costs[next];
+
+                if ( distance < Distance[next] )
+                {
+                    Distance[next] = distance;
+                    FirstMove[next] = ( cell == Source ) ? ( std::uint8_t ) ( MOVE_LEFT + i ) : FirstMove[cell];
+                    open.push( Entry( distance, next ));
+                }
+            }
+        }
+    }
+
+    // Run-length encode the first moves, breaking the runs at each row
+    static void CompressFirstMoves( int Width, int Cells, const std::vector <std::uint8_t> &FirstMove,
+                                    std::vector <std::uint32_t> &Runs )
+    {
+        Runs.clear( );
+
+        for ( int target = 0; target < Cells; target++ )
+        {
+            if ( target % Width == 0 || FirstMove[target] != FirstMove[target - 1] )
+            {
+                Runs.push_back((( std::uint32_t ) target << 3 ) | FirstMove[target] );
+            }
+        }
+
+        Runs.shrink_to_fit( );
+    }
+};
+
+#endif
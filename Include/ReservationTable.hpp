@@ -0,0 +1,331 @@
+/*
+ * Reservation table for cooperative (space-time) A*
+ *
+ * Part of the A* Algorithm Implementation using STL, see AStar.hpp for
+ * copyright and license information.
+ *
+ */
+
+#ifndef RESERVATION_TABLE_HPP
+#define RESERVATION_TABLE_HPP
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#include "MixHash.hpp"
+
+/**
+ * The reservation table remembers which agent occupies a cell (x, y) at a
+ * time step t. Agents plan one after the other in priority order, each one
+ * searching in space-time around the cells reserved by the agents planned
+ * before it, and then reserving its own path.
+ *
+ * The table is an open addressing hash with linear probing. Entries are only
+ * ever inserted, never removed, so both Reserve and the queries are lock-free
+ * and many threads may plan and reserve at the same time. Releasing a cell
+ * keeps its entry and only marks it free for the next agent. Clear must be
+ * called between ticks when no other thread is using the table.
+ */
+class ReservationTable
+{
+
+public:
+
+    // Returned by GetOwner when nobody has reserved the cell
+    static constexpr int NO_AGENT = -1;
+
+    // An entry whose key has been published but whose owner has not been
+    // written yet. It is treated as reserved by some other agent.
+    static constexpr int PENDING_AGENT = -2;
+
+    // An entry given back with Release, free for any agent to reserve
+    static constexpr int RELEASED_AGENT = -3;
+
+private: // data
+
+    class Slot
+    {
+
+    public:
+
+        std::atomic <std::uint64_t> key;
+        std::atomic <int> agent;
+
+        Slot( ) : key( 0 ), agent( PENDING_AGENT )
+        { }
+    };
+
+    std::unique_ptr <Slot[]> m_Slots;
+
+    // Capacity is always a power of two so the hash can be masked
+    std::uint64_t m_Mask;
+
+    std::atomic <unsigned int> m_Count;
+
+public: // methods
+
+    // Capacity is the maximum number of (cell, time) entries, it is rounded
+    // up to a power of two. Keep it at twice the expected number of entries
+    // to keep the probe sequences short.
+    explicit ReservationTable( unsigned int Capacity )
+    {
+        std::uint64_t size = 16;
+
+        while ( size < Capacity )
+        { size <<= 1; }
+
+        m_Slots.reset( new Slot[size] );
+        m_Mask = size - 1;
+        m_Count = 0;
+    }
+
+    // Reserve the cell (x, y) at time t for the agent. Returns false if
+    // another agent already holds it or if the table is full.
+    bool Reserve( int Agent, int x, int y, int t )
+    {
+        const std::uint64_t key = MakeKey( x, y, t );
+        std::uint64_t index = MixHash( key ) & m_Mask;
+
+        for ( std::uint64_t probe = 0; probe <= m_Mask; probe++ )
+        {
+            Slot &slot = m_Slots[index];
+            std::uint64_t current = slot.key.load( std::memory_order_acquire );
+
+            if ( current == 0 )
+            {
+                if ( slot.key.compare_exchange_strong( current, key, std::memory_order_acq_rel ))
+                {
+                    slot.agent.store( Agent, std::memory_order_release );
+                    m_Count.fetch_add( 1, std::memory_order_relaxed );
+                    return true;
+                }
+
+                // Another thread claimed the slot first, current now holds its key
+            }
+
+            if ( current == key )
+            {
+                int owner = slot.agent.load( std::memory_order_acquire );
+
+                // On failure owner holds the agent that took the cell first
+                if ( owner == RELEASED_AGENT &&
+                     slot.agent.compare_exchange_strong( owner, Agent, std::memory_order_acq_rel ))
+                {
+                    return true;
+                }
+
+                return owner == Agent;
+            }
+
+            index = ( index + 1 ) & m_Mask;
+        }
+
+        return false;
+    }
+
+    // Give back the cell (x, y) at time t if the agent holds it
+    void Release( int Agent, int x, int y, int t )
+    {
+        Slot *slot = FindSlot( x, y, t );
+
+        if ( slot )
+        {
+            int owner = Agent;
+            slot->agent.compare_exchange_strong( owner, RELEASED_AGENT, std::memory_order_acq_rel );
+        }
+    }
+
+    // Reserve the cell (x, y) from time t up to and including the last time
+    // step, used to keep an agent parked on its goal once it arrives
+    bool ReserveFrom( int Agent, int x, int y, int t, int Last )
+    {
+        bool ret = true;
+
+        for ( ; t <= Last; t++ )
+        {
+            ret = Reserve( Agent, x, y, t ) && ret;
+        }
+
+        return ret;
+    }
+
+    // Reserve a path found by a space-time search, point i being the cell at
+    // time i, then park the agent on the last cell up to the last time step.
+    // Agents planned by other threads may have taken some of the cells or
+    // crossed the path meanwhile, so the reserved path is checked again.
+    // Returns false if it collides and the agent must plan again, the cells
+    // it did get are then released so they do not block the other agents.
+    template <class Path> bool ReservePath( int Agent, const Path &Points, int Last )
+    {
+        if ( Points.empty( ))
+        {
+            return true;
+        }
+
+        bool ret = true;
+
+        for ( std::size_t t = 0; t < Points.size( ); t++ )
+        {
+            ret = Reserve( Agent, Points[t].x, Points[t].y, ( int ) t ) && ret;
+        }
+
+        ret = ReserveFrom( Agent, Points.back( ).x, Points.back( ).y, ( int ) Points.size( ), Last ) && ret;
+
+        if ( !ret )
+        {
+            ReleasePath( Agent, Points, Last );
+            return false;
+        }
+
+        // Of two threads reserving paths that swap places, at least one
+        // sees the reservations of the other after this fence
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+
+        for ( std::size_t t = 1; t < Points.size( ); t++ )
+        {
+            if ( !IsMoveFree( Agent, Points[t - 1].x, Points[t - 1].y, Points[t].x, Points[t].y, ( int ) t - 1 ))
+            {
+                ReleasePath( Agent, Points, Last );
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Who holds the cell (x, y) at time t
+    int GetOwner( int x, int y, int t ) const
+    {
+        const Slot *slot = FindSlot( x, y, t );
+
+        if ( !slot )
+        {
+            return NO_AGENT;
+        }
+
+        int owner = slot->agent.load( std::memory_order_acquire );
+
+        return ( owner == RELEASED_AGENT ) ? NO_AGENT : owner;
+    }
+
+    // True if the cell (x, y) at time t is held by an agent other than Agent
+    bool IsReserved( int Agent, int x, int y, int t ) const
+    {
+        int owner = GetOwner( x, y, t );
+
+        return owner != NO_AGENT && owner != Agent;
+    }
+
+    // True if the agent can move from (FromX, FromY) at time t to (ToX, ToY)
+    // at time t + 1. The destination must be free and the move must not swap
+    // places with another agent travelling in the opposite direction.
+    bool IsMoveFree( int Agent, int FromX, int FromY, int ToX, int ToY, int t ) const
+    {
+        if ( IsReserved( Agent, ToX, ToY, t + 1 ))
+        {
+            return false;
+        }
+
+        if ( FromX == ToX && FromY == ToY )
+        {
+            return true;
+        }
+
+        int owner = GetOwner( ToX, ToY, t );
+
+        if ( owner == NO_AGENT || owner == Agent )
+        {
+            return true;
+        }
+
+        return GetOwner( FromX, FromY, t + 1 ) != owner;
+    }
+
+    // True if no other agent uses the cell (x, y) from time t up to and
+    // including the last time step, so the agent can stay there
+    bool IsFreeFrom( int Agent, int x, int y, int t, int Last ) const
+    {
+        for ( ; t <= Last; t++ )
+        {
+            if ( IsReserved( Agent, x, y, t ))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    unsigned int GetCount( ) const
+    { return m_Count.load( std::memory_order_relaxed ); }
+
+    unsigned int GetCapacity( ) const
+    { return ( unsigned int ) ( m_Mask + 1 ); }
+
+    // Forget every reservation, not safe while other threads use the table
+    void Clear( )
+    {
+        for ( std::uint64_t index = 0; index <= m_Mask; index++ )
+        {
+            m_Slots[index].key.store( 0, std::memory_order_relaxed );
+            m_Slots[index].agent.store( PENDING_AGENT, std::memory_order_relaxed );
+        }
+
+        m_Count.store( 0, std::memory_order_release );
+    }
+
+private: // methods
+
+    // Slot holding the cell (x, y) at time t, nullptr if it was never reserved
+    Slot *FindSlot( int x, int y, int t ) const
+    {
+        const std::uint64_t key = MakeKey( x, y, t );
+        std::uint64_t index = MixHash( key ) & m_Mask;
+
+        for ( std::uint64_t probe = 0; probe <= m_Mask; probe++ )
+        {
+            Slot &slot = m_Slots[index];
+            std::uint64_t current = slot.key.load( std::memory_order_acquire );
+
+            if ( current == 0 )
+            {
+                return nullptr;
+            }
+
+            if ( current == key )
+            {
+                return &slot;
+            }
+
+            index = ( index + 1 ) & m_Mask;
+        }
+
+        return nullptr;
+    }
+
+    // Release every cell of a path reserved by ReservePath, the cells held by
+    // other agents are left alone
+    template <class Path> void ReleasePath( int Agent, const Path &Points, int Last )
+    {
+        for ( std::size_t t = 0; t < Points.size( ); t++ )
+        {
+            Release( Agent, Points[t].x, Points[t].y, ( int ) t );
+        }
+
+        for ( int t = ( int ) Points.size( ); t <= Last; t++ )
+        {
+            Release( Agent, Points.back( ).x, Points.back( ).y, t );
+        }
+    }
+
+    // Pack 20 bits of x and y and 23 bits of time, zero marks an empty slot
+    static std::uint64_t MakeKey( int x, int y, int t )
+    {
+        return ((( std::uint64_t ) ( t & 0x7FFFFF ) << 40 ) |
+                (( std::uint64_t ) ( y & 0xFFFFF ) << 20 ) |
+                (( std::uint64_t ) ( x & 0xFFFFF ))) + 1;
+    }
+};
+
+#endif
@@ -0,0 +1,222 @@
+/*
+ * Search trace recording for profiling the A* search
+ *
+ * Part of the A* Algorithm Implementation using STL, see AStar.hpp for
+ * copyright and license information.
+ *
+ */
+
+#ifndef SEARCH_TRACE_HPP
+#define SEARCH_TRACE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+enum class TraceEvent : std::uint8_t
+{
+    POP,    // node taken from the open list to be expanded
+    PUSH,   // new node pushed on the open list
+    UPDATE, // node already on the open list reached with a lower g
+    REOPEN, // closed node reached with a lower g and moved back to open
+    PRUNE   // successor dropped, a node of the same state is cheaper
+};
+
+// One event of the search, 32 bytes
+class TraceRecord
+{
+
+public:
+
+    std::uint64_t time; // nanoseconds since the trace was created or cleared
+    std::int32_t x;
+    std::int32_t y;
+    float g;
+    float h;
+    float f;
+    TraceEvent event;
+    std::uint8_t reserved[3]; // always zero, so the files hold no stray bytes
+};
+
+/**
+ * Records the events of a search in a ring buffer allocated up front, so
+ * recording never allocates. When the buffer is full the oldest events are
+ * overwritten. The events can be written to a compact binary file, read back
+ * by the TraceHeatmap tool, or to a Chrome trace JSON file that can be opened
+ * in chrome://tracing or Perfetto.
+ *
+ * AStar only records when it is compiled with ASTAR_TRACE defined, otherwise
+ * the hooks are compiled out.
+ */
+class SearchTrace
+{
+
+private: // data
+
+    std::vector <TraceRecord> m_Records;
+
+    // Next record to write and number of valid records
+    std::size_t m_Head;
+    std::size_t m_Size;
+
+    // Records lost because the buffer was full
+    std::uint64_t m_Dropped;
+
+    std::chrono::steady_clock::time_point m_Origin;
+
+public: // methods
+
+    explicit SearchTrace( std::size_t Capacity )
+    {
+        m_Records.resize( Capacity > 0 ? Capacity : 1 );
+        Clear( );
+    }
+
+    void Record( TraceEvent Event, int x, int y, float g, float h, float f )
+    {
+        TraceRecord &record = m_Records[m_Head];
+
+        record.time = ( std::uint64_t ) std::chrono::duration_cast <std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now( ) - m_Origin ).count( );
+        record.x = x;
+        record.y = y;
+        record.g = g;
+        record.h = h;
+        record.f = f;
+        record.event = Event;
+        record.reserved[0] = 0;
+        record.reserved[1] = 0;
+        record.reserved[2] = 0;
+
+        m_Head = ( m_Head + 1 ) % m_Records.size( );
+
+        if ( m_Size < m_Records.size( ))
+        {
+            m_Size += 1;
+        }
+        else
+        {
+            m_Dropped += 1;
+        }
+    }
+
+    void Clear( )
+    {
+        m_Head = 0;
+        m_Size = 0;
+        m_Dropped = 0;
+        m_Origin = std::chrono::steady_clock::now( );
+    }
+
+    std::size_t GetSize( ) const
+    { return m_Size; }
+
+    std::uint64_t GetDropped( ) const
+    { return m_Dropped; }
+
+    // Record i, the oldest one being 0
+    const TraceRecord &Get( std::size_t i ) const
+    {
+        return m_Records[( m_Head + m_Records.size( ) - m_Size + i ) % m_Records.size( )];
+    }
+
+    // Binary file: "AST1", the uint64 number of records then the records
+    bool WriteBinary( const char *FileName ) const
+    {
+        FILE *file = fopen( FileName, "wb" );
+
+        if ( !file )
+        {
+            return false;
+        }
+
+        std::uint64_t size = m_Size;
+        bool ret = fwrite( "AST1", 1, 4, file ) == 4 && fwrite( &size, sizeof( size ), 1, file ) == 1;
+
+        for ( std::size_t i = 0; ret && i < m_Size; i++ )
+        {
+            ret = fwrite( &Get( i ), sizeof( TraceRecord ), 1, file ) == 1;
+        }
+
+        return ( fclose( file ) == 0 ) && ret;
+    }
+
+    // Read back a file written by WriteBinary. Returns false for a file that
+    // is truncated or holds an event TraceEvent does not define.
+    static bool ReadBinary( const char *FileName, std::vector <TraceRecord> &Records )
+    {
+        FILE *file = fopen( FileName, "rb" );
+
+        if ( !file )
+        {
+            return false;
+        }
+
+        char magic[4];
+        std::uint64_t size = 0;
+        bool ret = fread( magic, 1, 4, file ) == 4 && magic[0] == 'A' && magic[1] == 'S' &&
+                   magic[2] == 'T' && magic[3] == '1' && fread( &size, sizeof( size ), 1, file ) == 1;
+
+        // The count comes from the file, check that the records are there
+        // before allocating them
+        const long header = ftell( file );
+
+        if ( ret && header >= 0 && fseek( file, 0, SEEK_END ) == 0 )
+        {
+            const long end = ftell( file );
+
+            ret = end >= header && size <= ( std::uint64_t ) ( end - header ) / sizeof( TraceRecord ) &&
+                  fseek( file, header, SEEK_SET ) == 0;
+        }
+        else
+        {
+            ret = false;
+        }
+
+        if ( ret )
+        {
+            Records.resize(( std::size_t ) size );
+            ret = fread( Records.data( ), sizeof( TraceRecord ), Records.size( ), file ) == Records.size( );
+        }
+
+        for ( std::size_t i = 0; ret && i < Records.size( ); i++ )
+        {
+            ret = Records[i].event <= TraceEvent::PRUNE;
+        }
+
+        fclose( file );
+        return ret;
+    }
+
+    // Chrome trace event format, one instant event per record
+    bool WriteChromeJson( const char *FileName ) const
+    {
+        static const char *names[] = { "pop", "push", "update", "reopen", "prune" };
+
+        FILE *file = fopen( FileName, "w" );
+
+        if ( !file )
+        {
+            return false;
+        }
+
+        fprintf( file, "{\"traceEvents\":[\n" );
+
+        for ( std::size_t i = 0; i < m_Size; i++ )
+        {
+            const TraceRecord &record = Get( i );
+
+            fprintf( file, "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":1,\"ts\":%.3f,"
+                           "\"args\":{\"x\":%d,\"y\":%d,\"g\":%g,\"h\":%g,\"f\":%g}}\n",
+                     i > 0 ? "," : "", names[( int ) record.event], ( double ) record.time / 1000.0,
+                     record.x, record.y, record.g, record.h, record.f );
+        }
+
+        fprintf( file, "],\"displayTimeUnit\":\"ns\"}\n" );
+
+        return fclose( file ) == 0;
+    }
+};
+
+#endif
@@ -0,0 +1,200 @@
+/*
+ * Lookup of the user states already seen by a search
+ *
+ * Part of the A* Algorithm Implementation using STL, see AStar.hpp for
+ * copyright and license information.
+ *
+ */
+
+#ifndef STATE_INDEX_HPP
+#define STATE_INDEX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "MixHash.hpp"
+
+// True when the user state provides Hash( ), which the searches then use to
+// look up the states they have seen instead of comparing them one by one
+template <class UserState> class HasHash
+{
+
+private:
+
+    template <class State> static auto Check( int ) -> decltype( std::declval< State & >( ).Hash( ), std::true_type( ));
+    template <class State> static std::false_type Check( ... );
+
+public:
+
+    enum : bool { value = decltype( Check< UserState >( 0 ))::value };
+};
+
+/**
+ * Finds the index of a state in the vector of states a search keeps, one
+ * entry per node. When the user state provides Hash( ) this is an open
+ * addressing table with linear probing of 8 byte slots, kept at most half
+ * full. A slot holds the high bits of the mixed hash, so the states are only
+ * read when they match. Without Hash( ) the states are compared one by one.
+ *
+ * The index does not own the states. Insert is called for each state pushed
+ * at the back of the vector, and Clear before the vector is emptied.
+ */
+template <class UserState> class StateIndex
+{
+
+public:
+
+    typedef std::uint32_t NodeIndex;
+
+    enum : NodeIndex { NO_NODE = 0xFFFFFFFF };
+
+private: // classes
+
+    class Entry
+    {
+
+    public:
+
+        std::uint32_t hash;
+        NodeIndex node; // NO_NODE for an empty slot
+    };
+
+    typedef std::integral_constant< bool, HasHash< UserState >::value > Hashed;
+
+private: // data
+
+    std::vector< Entry > m_Slots;
+
+public: // methods
+
+    // The index of the state, NO_NODE if it is not in States
+    NodeIndex Find( UserState &State, std::vector< UserState > &States )
+    {
+        return Find( State, States, Hashed( ));
+    }
+
+    // Add the last state of States
+    void Insert( std::vector< UserState > &States )
+    {
+        Insert( States, Hashed( ));
+    }
+
+    // Empty the slots of the states, so a short search after a long one does
+    // not pay for the whole table
+    void Clear( std::vector< UserState > &States )
+    {
+        Clear( States, Hashed( ));
+    }
+
+private: // methods
+
+    NodeIndex Find( UserState &State, std::vector< UserState > &States, std::false_type )
+    {
+        for ( std::size_t i = 0; i < States.size( ); i++ )
+        {
+            if ( States[i].IsSameState( State ))
+            {
+                return ( NodeIndex ) i;
+            }
+        }
+
+        return NO_NODE;
+    }
+
+    NodeIndex Find( UserState &State, std::vector< UserState > &States, std::true_type )
+    {
+        if ( m_Slots.empty( ))
+        {
+            return NO_NODE;
+        }
+
+        const std::uint64_t key = MixHash( State.Hash( ));
+        const std::uint32_t hash = ( std::uint32_t ) ( key >> 32 );
+        const std::size_t mask = m_Slots.size( ) - 1;
+
+        for ( std::size_t slot = ( std::size_t ) key & mask; m_Slots[slot].node != NO_NODE; slot = ( slot + 1 ) & mask )
+        {
+            if ( m_Slots[slot].hash == hash && States[m_Slots[slot].node].IsSameState( State ))
+            {
+                return m_Slots[slot].node;
+            }
+        }
+
+        return NO_NODE;
+    }
+
+    void Insert( std::vector< UserState > &, std::false_type )
+    { }
+
+    // Keep the table at most half full, growing it by doubling
+    void Insert( std::vector< UserState > &States, std::true_type )
+    {
+        const NodeIndex last = ( NodeIndex ) ( States.size( ) - 1 );
+
+        if ( States.size( ) * 2 > m_Slots.size( ))
+        {
+            Entry empty;
+            empty.hash = 0;
+            empty.node = NO_NODE;
+
+            m_Slots.assign( std::max< std::size_t >( 64, m_Slots.size( ) * 2 ), empty );
+
+            // The slots only keep part of the hash, so the earlier states are
+            // hashed again to find their new slots
+            for ( NodeIndex node = 0; node < last; node++ )
+            {
+                Place( States, node );
+            }
+        }
+
+        Place( States, last );
+    }
+
+    void Place( std::vector< UserState > &States, NodeIndex Index )
+    {
+        const std::uint64_t key = MixHash( States[Index].Hash( ));
+        const std::size_t mask = m_Slots.size( ) - 1;
+        std::size_t slot = ( std::size_t ) key & mask;
+
+        while ( m_Slots[slot].node != NO_NODE )
+        {
+            slot = ( slot + 1 ) & mask;
+        }
+
+        m_Slots[slot].hash = ( std::uint32_t ) ( key >> 32 );
+        m_Slots[slot].node = Index;
+    }
+
+    void Clear( std::vector< UserState > &, std::false_type )
+    { }
+
+    void Clear( std::vector< UserState > &States, std::true_type )
+    {
+        if ( m_Slots.empty( ))
+        {
+            return;
+        }
+
+        const std::size_t mask = m_Slots.size( ) - 1;
+
+        for ( NodeIndex node = 0; node < States.size( ); node++ )
+        {
+            // Every state is in the table, so the probe reaches its slot even
+            // past the slots already emptied
+            std::size_t slot = ( std::size_t ) MixHash( States[node].Hash( )) & mask;
+
+            while ( m_Slots[slot].node != node )
+            {
+                slot = ( slot + 1 ) & mask;
+            }
+
+            m_Slots[slot].node = NO_NODE;
+        }
+    }
+};
+
+#endif
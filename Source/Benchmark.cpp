@@ -0,0 +1,1076 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// STL A* Search implementation
+// (C)2001 Justin Heyes-Jones
+//
+// Benchmark of the path finders on the simple grid maze
+// Every query is answered by each path finder, the path costs are compared
+// to make sure they all return optimal paths
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "AStar.hpp" // See header for copyright and usage information
+#include "FringeSearch.hpp"
+#include "Graph.hpp"
+#include "ParallelAStar.hpp"
+#include "PathDatabase.hpp"
+#include "SearchNode.hpp"
+#include "SpaceTimeNode.hpp"
+#include "WorldMap.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// Number of random queries on the sample map
+constexpr int NUMBER_QUERIES = 2000;
+
+// Number of candidate goals of each nearest target query
+constexpr int NUMBER_TARGETS = 8;
+
+// Number of random queries on each generated maze
+constexpr int NUMBER_MAZE_QUERIES = 50;
+
+// Searches running while the map is edited
+constexpr int NUMBER_READERS = 4;
+
+// Agents planned cooperatively, the side of their map and the largest
+// distance between the start and the goal of an agent
+constexpr int NUMBER_AGENTS = 1000;
+constexpr int AGENT_MAP_SIZE = 128;
+constexpr int AGENT_DISTANCE = 24;
+
+// Times an agent plans again when its path collides with one reserved by
+// another thread meanwhile
+constexpr int NUMBER_REPLANS = 8;
+constexpr int EDIT_MILLISECONDS = 500;
+
+// Side of the maze searched by the parallel search and number of queries on it
+constexpr int PARALLEL_MAZE_SIZE = 401;
+constexpr int NUMBER_PARALLEL_QUERIES = 8;
+
+// Side of the largest maze searched as a graph
+constexpr int GRAPH_MAZE_SIZE = 1001;
+
+// Helpers
+
+// Read back the path of a path finder and return its cost on the map, -1 if it failed
+template <class PathFinder> float ConsumePath( PathFinder &pathFinder, const GridMap::Snapshot *map )
+{
+    if ( pathFinder.GetSearchState( ) != SearchState::SUCCEEDED )
+    {
+        return -1.0f;
+    }
+
+    float cost = 0.0f;
+    bool first = true;
+
+    while ( pathFinder.GetSizePath( ) > 0 )
+    {
+        Point2D point = pathFinder.Walk( );
+
+        if ( !first )
+        {
+            cost += ( float ) map->GetCell( point.x, point.y );
+        }
+
+        first = false;
+    }
+
+    return cost;
+}
+
+// Read back the path of a path finder, count its waypoints and the segments
+// between two waypoints that can not be walked straight on the map, and
+// return its straight line length, -1 if it failed
+template <class PathFinder> float ConsumeWaypoints( PathFinder &pathFinder, const GridMap::Snapshot *map,
+                                                    int &waypoints, int &blocked )
+{
+    if ( pathFinder.GetSearchState( ) != SearchState::SUCCEEDED )
+    {
+        return -1.0f;
+    }
+
+    float length = 0.0f;
+    SearchNode previous;
+
+    for ( int i = 0; pathFinder.GetSizePath( ) > 0; i++ )
+    {
+        Point2D point = pathFinder.Walk( );
+        SearchNode waypoint( point.x, point.y, map );
+
+        if ( i > 0 )
+        {
+            length += previous.GetDistance( waypoint );
+
+            if ( !previous.LineOfSight( waypoint ))
+            {
+                blocked += 1;
+            }
+        }
+
+        previous = waypoint;
+        waypoints += 1;
+    }
+
+    return length;
+}
+
+// Answer every query, store the path costs and return the time taken in microseconds
+template <class PathFinder> long long RunQueries( PathFinder &pathFinder,
+                                                  const vector <pair <SearchNode, SearchNode>> &queries,
+                                                  vector <float> &costs, int &failed )
+{
+    costs.assign( queries.size( ), -1.0f );
+    failed = 0;
+
+    auto start = high_resolution_clock::now( );
+
+    for ( size_t i = 0; i < queries.size( ); i++ )
+    {
+        pathFinder.ComputePath( queries[i].first, queries[i].second );
+        costs[i] = ConsumePath( pathFinder, queries[i].first.map );
+
+        if ( costs[i] < 0.0f )
+        {
+            failed += 1;
+        }
+        else
+        {
+            pathFinder.FreeSolutionNodes( );
+        }
+    }
+
+    auto stop = high_resolution_clock::now( );
+
+    return duration_cast <microseconds>( stop - start ).count( );
+}
+
+// Walkable cells of a map
+vector <SearchNode> WalkableCells( const GridMap::Snapshot *map )
+{
+    vector <SearchNode> walkable;
+
+    for ( int y = 0; y < map->GetHeight( ); y++ )
+    {
+        for ( int x = 0; x < map->GetWidth( ); x++ )
+        {
+            if ( map->GetCell( x, y ) < 9 )
+            {
+                walkable.push_back( SearchNode( x, y, map ));
+            }
+        }
+    }
+
+    return walkable;
+}
+
+// Random pairs of walkable cells of a map
+vector <pair <SearchNode, SearchNode>> RandomQueries( const GridMap::Snapshot *map, int count, mt19937 &random )
+{
+    vector <SearchNode> walkable = WalkableCells( map );
+
+    uniform_int_distribution <size_t> pick( 0, walkable.size( ) - 1 );
+    vector <pair <SearchNode, SearchNode>> queries;
+
+    for ( int i = 0; i < count; i++ )
+    {
+        queries.push_back( make_pair( walkable[pick( random )], walkable[pick( random )] ));
+    }
+
+    return queries;
+}
+
+// A maze carved by a randomised depth first search between the odd cells,
+// then one wall in eight knocked down to open loops. The corridors all cost
+// one, so many nodes share the same f.
+vector <int> GenerateMaze( int width, int height, mt19937 &random )
+{
+    vector <int> cells( width * height, 9 );
+    vector <int> stack;
+
+    cells[width + 1] = 1;
+    stack.push_back( width + 1 );
+
+    while ( !stack.empty( ))
+    {
+        int cell = stack.back( );
+        int x = cell % width;
+        int y = cell / width;
+
+        int directions[4];
+        int count = 0;
+
+        if ( x > 2 && cells[cell - 2] == 9 ) { directions[count++] = -1; }
+        if ( x < width - 3 && cells[cell + 2] == 9 ) { directions[count++] = 1; }
+        if ( y > 2 && cells[cell - 2 * width] == 9 ) { directions[count++] = -width; }
+        if ( y < height - 3 && cells[cell + 2 * width] == 9 ) { directions[count++] = width; }
+
+        if ( count == 0 )
+        {
+            stack.pop_back( );
+            continue;
+        }
+
+        int direction = directions[random( ) % count];
+
+        cells[cell + direction] = 1;
+        cells[cell + 2 * direction] = 1;
+        stack.push_back( cell + 2 * direction );
+    }
+
+    for ( int y = 1; y < height - 1; y++ )
+    {
+        for ( int x = 1; x < width - 1; x++ )
+        {
+            if ( cells[( y * width ) + x] == 9 && ( x + y ) % 2 == 1 && random( ) % 8 == 0 )
+            {
+                cells[( y * width ) + x] = 1;
+            }
+        }
+    }
+
+    return cells;
+}
+
+// Number of queries whose costs differ between two runs over the same queries
+int CountMismatches( const vector <float> &costs, const vector <float> &otherCosts )
+{
+    int mismatches = 0;
+
+    for ( size_t i = 0; i < costs.size( ) && i < otherCosts.size( ); i++ )
+    {
+        if ( costs[i] != otherCosts[i] )
+        {
+            mismatches += 1;
+        }
+    }
+
+    return mismatches;
+}
+
+// The walkable cells of a map as the nodes of a graph, linked to the cells
+// beside them at the cost AStar gives the move. NodeOfCell maps the cell
+// y * width + x to its node.
+void BuildGridGraph( const GridMap::Snapshot *map, Graph &graph, vector <uint32_t> &nodeOfCell )
+{
+    const int width = map->GetWidth( );
+    const int height = map->GetHeight( );
+
+    vector <Graph::Edge> edges;
+    vector <float> coordinates;
+
+    nodeOfCell.assign( width * height, GraphSearch::NO_NODE );
+
+    uint32_t nodes = 0;
+
+    for ( int y = 0; y < height; y++ )
+    {
+        for ( int x = 0; x < width; x++ )
+        {
+            if ( map->GetCell( x, y ) < 9 )
+            {
+                nodeOfCell[( y * width ) + x] = nodes++;
+                coordinates.push_back(( float ) x );
+                coordinates.push_back(( float ) y );
+            }
+        }
+    }
+
+    const int moves[4][2] = {{ -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 }};
+
+    for ( int y = 0; y < height; y++ )
+    {
+        for ( int x = 0; x < width; x++ )
+        {
+            if ( map->GetCell( x, y ) >= 9 )
+            {
+                continue;
+            }
+
+            for ( const int *move : moves )
+            {
+                const int nextX = x + move[0];
+                const int nextY = y + move[1];
+
+                if ( map->GetCell( nextX, nextY ) < 9 )
+                {
+                    edges.push_back( Graph::Edge( nodeOfCell[( y * width ) + x],
+                                                  nodeOfCell[( nextY * width ) + nextX],
+                                                  ( float ) map->GetCell( nextX, nextY )));
+                }
+            }
+        }
+    }
+
+    graph.Assign( nodes, edges, coordinates );
+}
+
+// Count the times two of the paths are on the same cell at the same time or
+// swap places, each agent staying on its last cell up to the time horizon
+int CountCollisions( const vector <vector <Point2D>> &paths )
+{
+    auto key = []( int x, int y, int t )
+    {
+        return (( uint64_t ) t << 40 ) | (( uint64_t ) ( y & 0xFFFFF ) << 20 ) | ( uint64_t ) ( x & 0xFFFFF );
+    };
+
+    auto at = []( const vector <Point2D> &path, int t )
+    {
+        return path[min( t, ( int ) path.size( ) - 1 )];
+    };
+
+    unordered_map <uint64_t, int> owners;
+    int collisions = 0;
+
+    for ( size_t agent = 0; agent < paths.size( ); agent++ )
+    {
+        for ( int t = 0; !paths[agent].empty( ) && t <= TIME_HORIZON; t++ )
+        {
+            Point2D point = at( paths[agent], t );
+
+            if ( !owners.insert( make_pair( key( point.x, point.y, t ), ( int ) agent )).second )
+            {
+                collisions += 1;
+            }
+        }
+    }
+
+    for ( size_t agent = 0; agent < paths.size( ); agent++ )
+    {
+        for ( int t = 0; !paths[agent].empty( ) && t < TIME_HORIZON; t++ )
+        {
+            Point2D from = at( paths[agent], t );
+            Point2D to = at( paths[agent], t + 1 );
+
+            if ( from.x == to.x && from.y == to.y )
+            {
+                continue;
+            }
+
+            auto before = owners.find( key( to.x, to.y, t ));
+            auto after = owners.find( key( from.x, from.y, t + 1 ));
+
+            // Counted once for each of the two agents
+            if ( before != owners.end( ) && after != owners.end( ) && before->second == after->second &&
+                 before->second != ( int ) agent )
+            {
+                collisions += 1;
+            }
+        }
+    }
+
+    return collisions;
+}
+
+void PrintResult( const char *name, long long microseconds, int failed )
+{
+    cout << setw( 20 ) << left << name << right << setw( 10 ) << microseconds << " us"
+         << setw( 10 ) << failed << " failed\n";
+}
+
+// Main
+
+int main( int argc, char *argv[] )
+{
+    cout << "\nSTL A* Search implementation\n\n(C) 2001 Justin Heyes-Jones\n\n";
+
+    GridMap world( MAP_WIDTH, MAP_HEIGHT, worldMap );
+    GridMap::ReadGuard snapshot( world );
+
+    // Random pairs of walkable cells
+
+    vector <SearchNode> walkable = WalkableCells( snapshot.Get( ));
+
+    mt19937 random( 2001 );
+    uniform_int_distribution <size_t> pick( 0, walkable.size( ) - 1 );
+
+    vector <pair <SearchNode, SearchNode>> queries;
+
+    for ( int i = 0; i < NUMBER_QUERIES; i++ )
+    {
+        queries.push_back( make_pair( walkable[pick( random )], walkable[pick( random )] ));
+    }
+
+    vector <float> costs( queries.size( ));
+
+    // Online search
+
+    {
+        ConnectedComponents components( MAP_WIDTH, MAP_HEIGHT, [&snapshot]( int x, int y )
+        {
+            return snapshot->GetCell( x, y ) < 9;
+        });
+
+        AStar <SearchNode> aStar;
+        aStar.SetComponents( &components );
+
+        int failed = 0;
+        auto start = high_resolution_clock::now( );
+
+        for ( size_t i = 0; i < queries.size( ); i++ )
+        {
+            aStar.ComputePath( queries[i].first, queries[i].second );
+            costs[i] = ConsumePath( aStar, snapshot.Get( ));
+
+            if ( costs[i] < 0.0f )
+            {
+                failed += 1;
+            }
+            else
+            {
+                aStar.FreeSolutionNodes( );
+            }
+        }
+
+        auto stop = high_resolution_clock::now( );
+        PrintResult( "AStar", duration_cast <microseconds>( stop - start ).count( ), failed );
+    }
+
+    // Any angle search against grid search, the any angle paths need fewer
+    // waypoints and are shorter
+
+    {
+        ConnectedComponents components( MAP_WIDTH, MAP_HEIGHT, [&snapshot]( int x, int y )
+        {
+            return snapshot->GetCell( x, y ) < 9;
+        });
+
+        AStar <SearchNode> aStar;
+        AStar <SearchNode, true> thetaStar;
+        aStar.SetComponents( &components );
+        thetaStar.SetComponents( &components );
+
+        int gridWaypoints = 0;
+        int anyAngleWaypoints = 0;
+        float gridLength = 0.0f;
+        float anyAngleLength = 0.0f;
+
+        // Segments between consecutive waypoints without line of sight
+        int gridBlocked = 0;
+        int anyAngleBlocked = 0;
+
+        int failed = 0;
+        auto start = high_resolution_clock::now( );
+
+        for ( size_t i = 0; i < queries.size( ); i++ )
+        {
+            thetaStar.ComputePath( queries[i].first, queries[i].second );
+            float length = ConsumeWaypoints( thetaStar, snapshot.Get( ), anyAngleWaypoints, anyAngleBlocked );
+
+            if ( length >= 0.0f )
+            {
+                anyAngleLength += length;
+                thetaStar.FreeSolutionNodes( );
+            }
+            else
+            {
+                failed += 1;
+            }
+        }
+
+        auto stop = high_resolution_clock::now( );
+        PrintResult( "AStar any angle", duration_cast <microseconds>( stop - start ).count( ), failed );
+
+        for ( size_t i = 0; i < queries.size( ); i++ )
+        {
+            aStar.ComputePath( queries[i].first, queries[i].second );
+            float length = ConsumeWaypoints( aStar, snapshot.Get( ), gridWaypoints, gridBlocked );
+
+            if ( length >= 0.0f )
+            {
+                gridLength += length;
+                aStar.FreeSolutionNodes( );
+            }
+        }
+
+        cout << "Waypoints: " << gridWaypoints << " on the grid, " << anyAngleWaypoints << " any angle\n";
+        cout << "Length: " << gridLength << " on the grid, " << anyAngleLength << " any angle\n";
+        cout << "Segments without line of sight: " << gridBlocked << " on the grid, " << anyAngleBlocked
+             << " any angle\n\n";
+    }
+
+    // Nearest of several targets, one search per target against a single
+    // search towards all of them
+
+    {
+        ConnectedComponents components( MAP_WIDTH, MAP_HEIGHT, [&snapshot]( int x, int y )
+        {
+            return snapshot->GetCell( x, y ) < 9;
+        });
+
+        AStar <SearchNode> aStar;
+        aStar.SetComponents( &components );
+
+        vector <vector <SearchNode>> targets( queries.size( ));
+
+        for ( vector <SearchNode> &candidates : targets )
+        {
+            for ( int i = 0; i < NUMBER_TARGETS; i++ )
+            {
+                candidates.push_back( walkable[pick( random )] );
+            }
+        }
+
+        vector <float> nearest( queries.size( ), -1.0f );
+        auto start = high_resolution_clock::now( );
+
+        for ( size_t i = 0; i < queries.size( ); i++ )
+        {
+            for ( SearchNode &target : targets[i] )
+            {
+                aStar.ComputePath( queries[i].first, target );
+                float cost = ConsumePath( aStar, snapshot.Get( ));
+
+                if ( cost >= 0.0f )
+                {
+                    aStar.FreeSolutionNodes( );
+
+                    if ( nearest[i] < 0.0f || cost < nearest[i] )
+                    {
+                        nearest[i] = cost;
+                    }
+                }
+            }
+        }
+
+        auto stop = high_resolution_clock::now( );
+
+        // A query fails when none of its targets can be reached
+        int failed = 0;
+
+        for ( float cost : nearest )
+        {
+            if ( cost < 0.0f )
+            {
+                failed += 1;
+            }
+        }
+
+        PrintResult( "AStar per target", duration_cast <microseconds>( stop - start ).count( ), failed );
+
+        int mismatches = 0;
+        failed = 0;
+        start = high_resolution_clock::now( );
+
+        for ( size_t i = 0; i < queries.size( ); i++ )
+        {
+            aStar.ComputePath( queries[i].first, targets[i] );
+            float cost = ConsumePath( aStar, snapshot.Get( ));
+
+            if ( cost >= 0.0f )
+            {
+                aStar.FreeSolutionNodes( );
+            }
+            else
+            {
+                failed += 1;
+            }
+
+            if ( cost != nearest[i] )
+            {
+                mismatches += 1;
+            }
+        }
+
+        stop = high_resolution_clock::now( );
+        PrintResult( "AStar nearest", duration_cast <microseconds>( stop - start ).count( ), failed );
+
+        cout << "Nearest targets with a different cost: " << mismatches << "\n\n";
+    }
+
+    // Compressed path database, built once and then only looked up
+
+    {
+        const char *fileName = "WorldMap.cpd";
+
+        auto start = high_resolution_clock::now( );
+
+        PathDatabase::Build( MAP_WIDTH, MAP_HEIGHT, [&snapshot]( int x, int y )
+        {
+            return snapshot->GetCell( x, y );
+        }, fileName );
+
+        auto stop = high_resolution_clock::now( );
+        PrintResult( "PathDatabase build", duration_cast <microseconds>( stop - start ).count( ), 0 );
+
+        PathDatabase database;
+
+        if ( !database.Open( fileName ))
+        {
+            cout << "Could not open " << fileName << "\n";
+            return 1;
+        }
+
+        int failed = 0;
+        int mismatches = 0;
+        start = high_resolution_clock::now( );
+
+        for ( size_t i = 0; i < queries.size( ); i++ )
+        {
+            database.ComputePath( queries[i].first, queries[i].second );
+            float cost = ConsumePath( database, snapshot.Get( ));
+
+            if ( cost < 0.0f )
+            {
+                failed += 1;
+            }
+
+            if ( cost != costs[i] )
+            {
+                mismatches += 1;
+            }
+        }
+
+        stop = high_resolution_clock::now( );
+        PrintResult( "PathDatabase", duration_cast <microseconds>( stop - start ).count( ), failed );
+
+        cout << "\nRuns: " << database.GetNumberRuns( ) << " for "
+             << MAP_WIDTH * MAP_HEIGHT << " sources\n";
+        cout << "Paths with a different cost: " << mismatches << "\n\n";
+    }
+
+    // Fringe search against AStar on the sample map and on generated mazes
+
+    {
+        AStar <SearchNode> aStar;
+        FringeSearch <SearchNode> fringe;
+
+        vector <float> fringeCosts;
+        int failed = 0;
+
+        long long microseconds = RunQueries( fringe, queries, fringeCosts, failed );
+        PrintResult( "FringeSearch", microseconds, failed );
+
+        cout << "Paths with a different cost: " << CountMismatches( fringeCosts, costs ) << "\n\n";
+
+        const int sizes[] = { 41, 81 };
+
+        for ( int size : sizes )
+        {
+            vector <int> maze = GenerateMaze( size, size, random );
+            GridMap mazeMap( size, size, maze.data( ));
+            GridMap::ReadGuard mazeSnapshot( mazeMap );
+
+            vector <pair <SearchNode, SearchNode>> mazeQueries = RandomQueries( mazeSnapshot.Get( ), NUMBER_MAZE_QUERIES,
+                                                                                random );
+            vector <float> aStarCosts;
+
+            cout << "Maze " << size << "x" << size << "\n";
+
+            microseconds = RunQueries( aStar, mazeQueries, aStarCosts, failed );
+            PrintResult( "AStar", microseconds, failed );
+
+            microseconds = RunQueries( fringe, mazeQueries, fringeCosts, failed );
+            PrintResult( "FringeSearch", microseconds, failed );
+
+            cout << "Paths with a different cost: " << CountMismatches( fringeCosts, aStarCosts ) << "\n\n";
+        }
+    }
+
+    // The mazes as graphs in compressed sparse row form, written to a file
+    // and mapped back, searched by GraphSearch
+
+    {
+        const int sizes[] = { 81, GRAPH_MAZE_SIZE };
+
+        for ( int size : sizes )
+        {
+            vector <int> maze = GenerateMaze( size, size, random );
+            GridMap mazeMap( size, size, maze.data( ));
+            GridMap::ReadGuard mazeSnapshot( mazeMap );
+
+            vector <pair <SearchNode, SearchNode>> mazeQueries = RandomQueries( mazeSnapshot.Get( ), NUMBER_MAZE_QUERIES,
+                                                                                random );
+
+            Graph built;
+            vector <uint32_t> nodeOfCell;
+
+            auto start = high_resolution_clock::now( );
+            BuildGridGraph( mazeSnapshot.Get( ), built, nodeOfCell );
+            bool written = built.Write( "Maze.csr" );
+            auto stop = high_resolution_clock::now( );
+
+            Graph graph;
+
+            if ( !written || !graph.Open( "Maze.csr" ))
+            {
+                cout << "Could not write the graph Maze.csr\n";
+                return 1;
+            }
+
+            cout << "Maze " << size << "x" << size << ", " << graph.GetNumberNodes( ) << " nodes, "
+                 << graph.GetNumberEdges( ) << " edges\n";
+
+            PrintResult( "Graph build", duration_cast <microseconds>( stop - start ).count( ), 0 );
+
+            GraphSearch graphSearch;
+            vector <float> graphCosts( mazeQueries.size( ), -1.0f );
+            int failed = 0;
+
+            start = high_resolution_clock::now( );
+
+            for ( size_t i = 0; i < mazeQueries.size( ); i++ )
+            {
+                const SearchNode &from = mazeQueries[i].first;
+                const SearchNode &to = mazeQueries[i].second;
+
+                if ( graphSearch.ComputePath( graph, nodeOfCell[( from.y * size ) + from.x],
+                                              nodeOfCell[( to.y * size ) + to.x] ) == SearchState::SUCCEEDED )
+                {
+                    graphCosts[i] = graphSearch.GetCost( );
+                }
+                else
+                {
+                    failed += 1;
+                }
+            }
+
+            stop = high_resolution_clock::now( );
+
+            PrintResult( "GraphSearch", duration_cast <microseconds>( stop - start ).count( ), failed );
+
+            // AStar searches the same maze through the user state, it must
+            // find paths of the same cost
+            AStar <SearchNode> aStar;
+            vector <float> aStarCosts;
+
+            long long microseconds = RunQueries( aStar, mazeQueries, aStarCosts, failed );
+            PrintResult( "AStar", microseconds, failed );
+
+            cout << "Paths with a different cost: " << CountMismatches( graphCosts, aStarCosts ) << "\n";
+
+            cout << "\n";
+        }
+    }
+
+    // Speedup of the parallel search with the number of threads on a large
+    // maze, the one thread run is the reference
+
+    {
+        vector <int> maze = GenerateMaze( PARALLEL_MAZE_SIZE, PARALLEL_MAZE_SIZE, random );
+        GridMap mazeMap( PARALLEL_MAZE_SIZE, PARALLEL_MAZE_SIZE, maze.data( ));
+        GridMap::ReadGuard mazeSnapshot( mazeMap );
+
+        vector <pair <SearchNode, SearchNode>> mazeQueries = RandomQueries( mazeSnapshot.Get( ),
+                                                                            NUMBER_PARALLEL_QUERIES, random );
+        vector <float> referenceCosts;
+        long long referenceMicroseconds = 0;
+
+        cout << "Maze " << PARALLEL_MAZE_SIZE << "x" << PARALLEL_MAZE_SIZE << ", "
+             << thread::hardware_concurrency( ) << " cores\n";
+
+        const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+
+        for ( unsigned int threads : threadCounts )
+        {
+            ParallelAStar <SearchNode> parallel( threads );
+
+            vector <float> parallelCosts;
+            int failed = 0;
+
+            long long microseconds = RunQueries( parallel, mazeQueries, parallelCosts, failed );
+
+            if ( threads == 1 )
+            {
+                referenceCosts = parallelCosts;
+                referenceMicroseconds = microseconds;
+            }
+
+            string name = "ParallelAStar x" + to_string( threads );
+            PrintResult( name.c_str( ), microseconds, failed );
+
+            cout << "Speedup: " << fixed << setprecision( 2 )
+                 << ( double ) referenceMicroseconds / ( double ) max( microseconds, 1LL )
+                 << defaultfloat << ", paths with a different cost: " << CountMismatches( parallelCosts, referenceCosts )
+                 << "\n";
+        }
+
+        cout << "\n";
+    }
+
+    // Cooperative planning of many agents, one after the other and then on
+    // several threads sharing the reservation table. An agent whose path
+    // collides with a path reserved meanwhile by another thread plans again.
+
+    {
+        vector <int> cells( AGENT_MAP_SIZE * AGENT_MAP_SIZE, 1 );
+
+        for ( int &cell : cells )
+        {
+            if ( random( ) % 10 == 0 )
+            {
+                cell = 9;
+            }
+        }
+
+        GridMap agentMap( AGENT_MAP_SIZE, AGENT_MAP_SIZE, cells.data( ));
+        GridMap::ReadGuard pinned( agentMap );
+
+        ConnectedComponents components( AGENT_MAP_SIZE, AGENT_MAP_SIZE, [&pinned]( int x, int y )
+        {
+            return pinned->GetCell( x, y ) < 9;
+        });
+
+        // Distinct starts and distinct goals, each goal reachable from its start
+        vector <SearchNode> walkable = WalkableCells( pinned.Get( ));
+        uniform_int_distribution <size_t> pickCell( 0, walkable.size( ) - 1 );
+        uniform_int_distribution <int> offset( -AGENT_DISTANCE / 2, AGENT_DISTANCE / 2 );
+
+        vector <bool> usedStart( cells.size( ), false );
+        vector <bool> usedGoal( cells.size( ), false );
+        vector <pair <Point2D, Point2D>> agents;
+
+        while ( agents.size( ) < NUMBER_AGENTS )
+        {
+            SearchNode from = walkable[pickCell( random )];
+            int x = from.x + offset( random );
+            int y = from.y + offset( random );
+
+            if ( pinned->GetCell( x, y ) >= 9 || usedStart[( from.y * AGENT_MAP_SIZE ) + from.x] ||
+                 usedGoal[( y * AGENT_MAP_SIZE ) + x] || !components.IsConnected( from.x, from.y, x, y ))
+            {
+                continue;
+            }
+
+            usedStart[( from.y * AGENT_MAP_SIZE ) + from.x] = true;
+            usedGoal[( y * AGENT_MAP_SIZE ) + x] = true;
+            agents.push_back( make_pair( Point2D( from.x, from.y ), Point2D( x, y )));
+        }
+
+        cout << NUMBER_AGENTS << " agents on a " << AGENT_MAP_SIZE << "x" << AGENT_MAP_SIZE << " map\n";
+
+        const int threadCounts[] = { 1, NUMBER_READERS };
+
+        for ( int threads : threadCounts )
+        {
+            ReservationTable table( 1 << 20 );
+            vector <vector <Point2D>> paths( agents.size( ));
+
+            atomic <int> nextAgent( 0 );
+            atomic <int> failed( 0 );
+            atomic <int> replans( 0 );
+
+            auto planner = [&]( )
+            {
+                AStar <SpaceTimeNode> aStar;
+
+                for ( int agent = nextAgent++; agent < ( int ) agents.size( ); agent = nextAgent++ )
+                {
+                    const Point2D &from = agents[agent].first;
+                    const Point2D &to = agents[agent].second;
+
+                    for ( int attempt = 0; ; attempt++ )
+                    {
+                        aStar.ComputePath( SpaceTimeNode( from.x, from.y, 0, agent, &table, pinned.Get( )),
+                                           SpaceTimeNode( to.x, to.y, 0, agent, &table, pinned.Get( )));
+
+                        if ( aStar.GetSearchState( ) != SearchState::SUCCEEDED || attempt == NUMBER_REPLANS )
+                        {
+                            failed += 1;
+                            break;
+                        }
+
+                        vector <Point2D> path;
+
+                        while ( aStar.GetSizePath( ) > 0 )
+                        {
+                            path.push_back( aStar.Walk( ));
+                        }
+
+                        aStar.FreeSolutionNodes( );
+
+                        if ( table.ReservePath( agent, path, TIME_HORIZON ))
+                        {
+                            paths[agent] = path;
+                            break;
+                        }
+
+                        replans += 1;
+                    }
+                }
+            };
+
+            auto start = high_resolution_clock::now( );
+
+            vector <thread> planners;
+
+            for ( int i = 1; i < threads; i++ )
+            {
+                planners.emplace_back( planner );
+            }
+
+            planner( );
+
+            for ( thread &thread : planners )
+            {
+                thread.join( );
+            }
+
+            auto stop = high_resolution_clock::now( );
+            long long elapsed = duration_cast <microseconds>( stop - start ).count( );
+
+            string name = "Agents x" + to_string( threads );
+            PrintResult( name.c_str( ), elapsed, failed );
+
+            cout << "Agents per second: " << ( long long ) agents.size( ) * 1000000 / max( elapsed, 1LL )
+                 << ", replans: " << replans << ", collisions: " << CountCollisions( paths ) << "\n";
+        }
+
+        cout << "\n";
+    }
+
+    // Searches on a maze while a writer keeps opening and closing walls. Each
+    // search reads the snapshot it pinned, so every path it returns must be
+    // walkable in that snapshot.
+
+    {
+        const int size = 41;
+
+        vector <int> maze = GenerateMaze( size, size, random );
+        GridMap mazeMap( size, size, maze.data( ));
+
+        atomic <bool> stop( false );
+        atomic <int> searches( 0 );
+        atomic <int> invalid( 0 );
+
+        auto reader = [&]( unsigned int seed )
+        {
+            mt19937 readerRandom( seed );
+            uniform_int_distribution <int> cell( 1, size - 2 );
+            AStar <SearchNode> aStar;
+
+            while ( !stop )
+            {
+                GridMap::ReadGuard pinned( mazeMap );
+
+                SearchNode start( cell( readerRandom ), cell( readerRandom ), pinned.Get( ));
+                SearchNode goal( cell( readerRandom ), cell( readerRandom ), pinned.Get( ));
+
+                if ( pinned->GetCell( start.x, start.y ) >= 9 || pinned->GetCell( goal.x, goal.y ) >= 9 )
+                {
+                    continue;
+                }
+
+                if ( aStar.ComputePath( start, goal ) == SearchState::SUCCEEDED )
+                {
+                    Point2D previous = aStar.Walk( );
+
+                    while ( aStar.GetSizePath( ) > 0 )
+                    {
+                        Point2D point = aStar.Walk( );
+
+                        if ( pinned->GetCell( point.x, point.y ) >= 9 ||
+                             abs( point.x - previous.x ) + abs( point.y - previous.y ) != 1 )
+                        {
+                            invalid += 1;
+                        }
+
+                        previous = point;
+                    }
+
+                    aStar.FreeSolutionNodes( );
+                }
+
+                searches += 1;
+            }
+        };
+
+        vector <thread> readers;
+
+        for ( int i = 0; i < NUMBER_READERS; i++ )
+        {
+            readers.emplace_back( reader, 3000 + i );
+        }
+
+        // The writer toggles a batch of inner cells per version and keeps a
+        // component labelling up to date with them, checked against a
+        // labelling built from scratch after each batch
+        auto isWalkable = [&maze]( int x, int y )
+        {
+            return maze[( y * size ) + x] < 9;
+        };
+
+        ConnectedComponents components( size, size, isWalkable );
+        int labellingMismatches = 0;
+        int mostLabels = 0;
+
+        uniform_int_distribution <int> cell( 1, size - 2 );
+        auto deadline = steady_clock::now( ) + milliseconds( EDIT_MILLISECONDS );
+
+        while ( steady_clock::now( ) < deadline )
+        {
+            vector <GridMap::Edit> edits;
+
+            for ( int i = 0; i < 8; i++ )
+            {
+                int x = cell( random );
+                int y = cell( random );
+
+                maze[( y * size ) + x] = ( maze[( y * size ) + x] < 9 ) ? 9 : 1;
+                edits.push_back( GridMap::Edit( x, y, maze[( y * size ) + x] ));
+
+                if ( maze[( y * size ) + x] < 9 )
+                {
+                    components.Unblock( x, y );
+                }
+                else
+                {
+                    components.Block( x, y );
+                }
+            }
+
+            mazeMap.Apply( edits );
+            mostLabels = max( mostLabels, components.GetNumberLabels( ));
+
+            // Both labellings must split the cells into the same components,
+            // whatever numbers they give them
+            ConnectedComponents rebuilt( size, size, isWalkable );
+            unordered_map <int, int> incrementalOf;
+            unordered_map <int, int> rebuiltOf;
+
+            for ( int y = 0; y < size; y++ )
+            {
+                for ( int x = 0; x < size; x++ )
+                {
+                    int incremental = components.GetComponent( x, y );
+                    int fresh = rebuilt.GetComponent( x, y );
+
+                    if (( incremental == ConnectedComponents::BLOCKED ) != ( fresh == ConnectedComponents::BLOCKED ) ||
+                        incrementalOf.insert( make_pair( fresh, incremental )).first->second != incremental ||
+                        rebuiltOf.insert( make_pair( incremental, fresh )).first->second != fresh )
+                    {
+                        labellingMismatches += 1;
+                    }
+                }
+            }
+        }
+
+        stop = true;
+
+        for ( thread &thread : readers )
+        {
+            thread.join( );
+        }
+
+        cout << "Maze " << size << "x" << size << " edited while searched\n";
+        cout << "Versions: " << mazeMap.GetVersion( ) << ", searches: " << searches
+             << ", invalid paths: " << invalid << "\n";
+        cout << "Cells labelled in another component than after a full labelling: " << labellingMismatches << "\n";
+        cout << "Most labels in use: " << mostLabels << " for " << size * size << " cells\n";
+    }
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// STL A* Search implementation
+// (C)2001 Justin Heyes-Jones
+//
+// Cooperative path finding for several agents on the simple grid maze
+// Each agent searches in space-time around the reservations of the agents
+// planned before it, so the resulting paths never collide
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "AStar.hpp" // See header for copyright and usage information
+#include "ReservationTable.hpp"
+#include "SpaceTimeNode.hpp"
+#include "WorldMap.hpp"
+
+#include <iostream>
+#include <cmath>
+#include <chrono>
+#include <iomanip>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// Main
+
+int main( int argc, char *argv[] )
+{
+    cout << "\nSTL A* Search implementation\n\n(C) 2001 Justin Heyes-Jones\n";
+
+    auto start = high_resolution_clock::now();
+
+    // Start and goal of each agent, listed in priority order. Several of them
+    // cross each other in the corridors of the maze.
+    const int agents[][4] =
+    {
+        {  3,  5, 17, 15 },
+        { 17, 15,  3,  5 },
+        {  0,  0, 19, 19 },
+        { 19, 19,  0,  0 },
+        { 10,  2, 10, 18 },
+        { 10, 18, 10,  2 },
+    };
+
+    GridMap world( MAP_WIDTH, MAP_HEIGHT, worldMap );
+    GridMap::ReadGuard snapshot( world );
+
+    // Cells reserved by the agents that already have a path
+    ReservationTable reservations( 1 << 14 );
+
+    int conflicts = 0;
+
+    for ( int agentIndex = 0; agentIndex < ( int ) ( sizeof( agents ) / sizeof( agents[0] )); agentIndex++ )
+    {
+        const int *agent = agents[agentIndex];
+
+        SearchState state;
+        AStar <SpaceTimeNode> aStar;
+
+        state = aStar.ComputePath( SpaceTimeNode( agent[0], agent[1], 0, agentIndex, &reservations, snapshot.Get( )),
+                                   SpaceTimeNode( agent[2], agent[3], 0, agentIndex, &reservations, snapshot.Get( )));
+
+        cout << "\nAgent " << agentIndex << " : (" << setw( 2 ) << agent[0] << ", " << setw( 2 ) << agent[1]
+             << ") -> (" << setw( 2 ) << agent[2] << ", " << setw( 2 ) << agent[3] << ")";
+
+        if ( state != SearchState::SUCCEEDED )
+        {
+            cout << " did not find a path\n";
+            continue;
+        }
+
+        // The time step of each point is its position in the path
+        vector <Point2D> path;
+        int waits = 0;
+
+        while ( aStar.GetSizePath( ) > 0 )
+        {
+            Point2D point = aStar.Walk( );
+
+            if ( !path.empty( ) && point.x == path.back( ).x && point.y == path.back( ).y )
+            {
+                waits += 1;
+            }
+
+            path.push_back( point );
+        }
+
+        // Reserve the path and park the agent on its goal
+        if ( !reservations.ReservePath( agentIndex, path, TIME_HORIZON ))
+        {
+            conflicts += 1;
+        }
+
+        cout << " arrives at t = " << path.size( ) - 1 << " after " << waits << " waits, "
+             << aStar.GetNumberSteps( ) << " search steps\n";
+
+        aStar.FreeSolutionNodes( );
+    }
+
+    cout << "\nReservations: " << reservations.GetCount( ) << "\n";
+    cout << "Conflicts: " << conflicts << "\n";
+
+    auto stop = high_resolution_clock::now();
+    auto duration = duration_cast<microseconds>(stop - start);
+
+    cout << "\nMicroseconds: " << duration.count() << "\n";
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -9,6 +9,8 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "AStar.hpp" // See header for copyright and usage information
+#include "SearchNode.hpp"
+#include "WorldMap.hpp"
 
 #include <iostream>
 #include <cmath>
@@ -18,160 +20,6 @@
 using namespace std;
 using namespace std::chrono;
 
-// Global data
-
-// The world map
-
-constexpr short MAP_WIDTH = 20;
-constexpr short MAP_HEIGHT = 20;
-
-constexpr int worldMap[MAP_WIDTH * MAP_HEIGHT ] =
-{
-
-//  0  1  2  3  4  5  6  7  8  9 10 11 12 13 14 15 16 17 18 19
-                1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   // 00
-                1, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 1,   // 01
-                1, 9, 9, 1, 1, 9, 9, 9, 1, 9, 1, 9, 1, 9, 1, 9, 9, 9, 1, 1,   // 02
-                1, 9, 9, 1, 1, 9, 9, 9, 1, 9, 1, 9, 1, 9, 1, 9, 9, 9, 1, 1,   // 03
-                1, 9, 1, 1, 1, 1, 9, 9, 1, 9, 1, 9, 1, 1, 1, 1, 9, 9, 1, 1,   // 04
-                1, 9, 1, 1, 9, 1, 1, 1, 1, 9, 1, 1, 1, 1, 9, 1, 1, 1, 1, 1,   // 05
-                1, 9, 9, 9, 9, 1, 1, 1, 1, 1, 1, 9, 9, 9, 9, 1, 1, 1, 1, 1,   // 06
-                1, 9, 9, 9, 9, 9, 9, 9, 9, 1, 1, 1, 9, 9, 9, 9, 9, 9, 9, 1,   // 07
-                1, 9, 1, 1, 1, 1, 1, 1, 1, 1, 1, 9, 1, 1, 1, 1, 1, 1, 1, 1,   // 08
-                1, 9, 1, 9, 9, 9, 9, 9, 9, 9, 1, 1, 9, 9, 9, 9, 9, 9, 9, 1,   // 09
-                1, 9, 1, 1, 1, 1, 9, 1, 1, 9, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   // 10
-                1, 9, 9, 9, 9, 9, 1, 9, 1, 9, 1, 9, 9, 9, 9, 9, 1, 1, 1, 1,   // 11
-                1, 9, 1, 9, 1, 9, 9, 9, 1, 9, 1, 9, 1, 9, 1, 9, 9, 9, 1, 1,   // 12
-                1, 9, 1, 9, 1, 9, 9, 9, 1, 9, 1, 9, 1, 9, 1, 9, 9, 9, 1, 1,   // 13
-                1, 9, 1, 1, 1, 1, 9, 9, 1, 9, 1, 9, 1, 1, 1, 1, 9, 9, 1, 1,   // 14
-                1, 9, 1, 1, 9, 1, 1, 1, 1, 9, 1, 1, 1, 1, 9, 1, 1, 1, 1, 1,   // 15
-                1, 9, 9, 9, 9, 1, 1, 1, 1, 1, 1, 9, 9, 9, 9, 1, 1, 1, 1, 1,   // 16
-                1, 1, 9, 9, 9, 9, 9, 9, 9, 1, 1, 1, 9, 9, 9, 1, 9, 9, 9, 9,   // 17
-                1, 9, 1, 1, 1, 1, 1, 1, 1, 1, 1, 9, 1, 1, 1, 1, 1, 1, 1, 1,   // 18
-                1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   // 19
-
-};
-
-// map helper functions
-
-int GetMap( int x, int y )
-{
-	if( x < 0 || x >= MAP_WIDTH ||
-	    y < 0 || y >= MAP_HEIGHT )
-	{
-		return 9;	 
-	}
-
-	return worldMap[ ( y * MAP_WIDTH) + x];
-}
-
-
-
-// Definitions
-
-class SearchNode
-{
-
-public:
-
-	int x;	 // the (x,y) positions of the node
-	int y;	
-	
-	SearchNode() { x = y = 0; }
-	SearchNode( int px, int py ) { x=px; y=py; }
-
-	float GoalDistanceEstimate( SearchNode &nodeGoal );
-	bool IsGoal( SearchNode &nodeGoal );
-
-    bool GetSuccessors( AStar <SearchNode> *nAStar, SearchNode *nParentNode );
-	float GetCost( SearchNode &successor );
-	bool IsSameState( SearchNode &rhs );
-
-	void PrintNodeInfo(); 
-
-
-};
-
-bool SearchNode::IsSameState( SearchNode &rhs )
-{
-	// same state in a maze search is simply when (x,y) are the same
-    return ( x == rhs.x ) && ( y == rhs.y );
-}
-
-void SearchNode::PrintNodeInfo()
-{
-	cout << "Node position : (" << setw(2) << x << ", " << setw(2) << y << ")\n";
-}
-
-// Here's the heuristic function that estimates the distance from a Node
-// to the Goal. The distance is estimate with Manhattan distance.
-float SearchNode::GoalDistanceEstimate( SearchNode &nodeGoal )
-{
-	return abs(x - nodeGoal.x) + abs(y - nodeGoal.y);
-}
-
-bool SearchNode::IsGoal( SearchNode &nodeGoal )
-{
-    return ( x == nodeGoal.x ) && ( y == nodeGoal.y );
-}
-
-// This generates the successors to the given Node. It uses a helper function called
-// AddSuccessor to give the successors to the AStar class. The A* specific initialisation
-// is done for each node internally, so here you just set the state information that
-// is specific to the application
-bool SearchNode::GetSuccessors( AStar <SearchNode> *nAStar, SearchNode *nParentNode )
-{
-
-	int parentX = -1;
-	int parentY = -1;
-
-    if ( nParentNode )
-    {
-        parentX = nParentNode->x;
-        parentY = nParentNode->y;
-	}
-	
-
-	SearchNode NewNode;
-
-	// push each possible move except allowing the search to go backwards
-
-    if (( GetMap( x - 1, y ) < 9 ) && !( parentX == x - 1 && parentY == y ))
-	{
-		NewNode = SearchNode( x - 1, y );
-        nAStar->AddSuccessor( NewNode );
-	}
-
-    if (( GetMap( x + 1, y ) < 9 ) && !( parentX == x + 1 && parentY == y ))
-    {
-        NewNode = SearchNode( x + 1, y );
-        nAStar->AddSuccessor( NewNode );
-    }
-
-    if (( GetMap( x, y - 1 ) < 9 ) && !( parentX == x && parentY == y - 1 ))
-	{
-        NewNode = SearchNode( x, y - 1 );
-        nAStar->AddSuccessor( NewNode );
-    }
-
-    if (( GetMap( x, y + 1 ) < 9 ) && !( parentX == x && parentY == y + 1 ))
-	{
-		NewNode = SearchNode( x, y + 1 );
-        nAStar->AddSuccessor( NewNode );
-	}	
-
-	return true;
-}
-
-// given this node, what does it cost to move to successor. In the case
-// of our map the answer is the map terrain value at this node since that is 
-// conceptually where we're moving
-float SearchNode::GetCost( SearchNode &successor )
-{
-    return ( float ) GetMap( successor.x, successor.y );
-}
-
-
 // Main
 
 int main( int argc, char *argv[] )
@@ -189,18 +37,43 @@ int main( int argc, char *argv[] )
 	// in travelling (think ice rink if you can skate) whilst 5 represents the 
 	// most difficult. 9 indicates that we cannot pass.
 
+    // The map can be edited while it is searched, the searches read the
+    // snapshot that was current when they started
+    GridMap world( MAP_WIDTH, MAP_HEIGHT, worldMap );
+    GridMap::ReadGuard snapshot( world );
+
     // Create a start state
-    SearchNode nodeStart( 3, 5 );
+    SearchNode nodeStart( 3, 5, snapshot.Get( ));
 
     // Define the goal state
-    SearchNode nodeEnd( 17, 15 );
+    SearchNode nodeEnd( 17, 15, snapshot.Get( ));
+
+    // Label the regions of the map once, queries between two regions that
+    // are not connected are rejected without searching
+    ConnectedComponents components( MAP_WIDTH, MAP_HEIGHT, [&snapshot]( int x, int y )
+    {
+        return snapshot->GetCell( x, y ) < 9;
+    });
 
     // Create an instance of the search class...
     // Set Start and goal states
     AStar <SearchNode> aStar;
+    aStar.SetComponents( &components );
+
+#ifdef ASTAR_TRACE
+    // Record the search, render it with TraceHeatmap FindPath.trace
+    SearchTrace trace( 1 << 16 );
+    aStar.SetTrace( &trace );
+#endif
 
     aStar.ComputePath( nodeStart, nodeEnd );
 
+#ifdef ASTAR_TRACE
+    aStar.SetTrace( nullptr );
+    trace.WriteBinary( "FindPath.trace" );
+    trace.WriteChromeJson( "FindPath.trace.json" );
+#endif
+
     if ( aStar.GetSearchState( ) == SearchState::SUCCEEDED )
     {
         cout << "\nSearch found goal state\n\n";
@@ -228,6 +101,83 @@ int main( int argc, char *argv[] )
 
     }
 
+    // The same path in any angle mode, only the turning points are left
+    AStar <SearchNode, true> thetaStar;
+
+    if ( thetaStar.ComputePath( nodeStart, nodeEnd ) == SearchState::SUCCEEDED )
+    {
+        cout << "\nAny angle path\n\n";
+
+        int waypoints = 0;
+        float length = 0.0f;
+        SearchNode previous;
+
+        while ( thetaStar.GetSizePath( ) > 0 )
+        {
+            Point2D point = thetaStar.Walk( );
+            SearchNode waypoint( point.x, point.y, snapshot.Get( ));
+
+            cout << "Node position : (" << setw( 2 ) << point.x << ", " << setw( 2 ) << point.y << ")\n";
+
+            if ( waypoints > 0 )
+            {
+                length += previous.GetDistance( waypoint );
+            }
+
+            previous = waypoint;
+            waypoints += 1;
+        }
+
+        cout << "\nWaypoints: " << waypoints << endl;
+        cout << "Length: " << length << endl;
+
+        thetaStar.FreeSolutionNodes( );
+    }
+
+    // Find the nearest of the four corners of the map in a single search
+    vector< SearchNode > corners = { SearchNode( 0, 0, snapshot.Get( )), SearchNode( 19, 0, snapshot.Get( )),
+                                     SearchNode( 0, 19, snapshot.Get( )), SearchNode( 19, 19, snapshot.Get( )) };
+
+    if ( aStar.ComputePath( nodeStart, corners ) == SearchState::SUCCEEDED )
+    {
+        SearchNode *corner = aStar.GetSolutionEnd( );
+
+        cout << "\nNearest corner (" << setw( 2 ) << corner->x << ", " << setw( 2 ) << corner->y
+             << ") found in " << aStar.GetNumberSteps( ) << " steps\n";
+
+        while ( aStar.GetSizePath( ) > 0 )
+        { aStar.Walk( ); }
+
+        aStar.FreeSolutionNodes( );
+    }
+
+    // The cell (6, 11) is a pocket enclosed by walls
+    SearchNode nodePocket( 6, 11, snapshot.Get( ));
+
+    if ( aStar.ComputePath( nodeStart, nodePocket ) == SearchState::FAILED )
+    {
+        cout << "\nSearch to the pocket rejected after " << aStar.GetNumberSteps( ) << " steps\n";
+    }
+
+    // Close the corridor the path goes through, the snapshot pinned above
+    // still holds the original map
+    world.Apply( { GridMap::Edit( 14, 10, 9 ) } );
+
+    {
+        GridMap::ReadGuard edited( world );
+        AStar <SearchNode> detour;
+
+        if ( detour.ComputePath( SearchNode( 3, 5, edited.Get( )), SearchNode( 17, 15, edited.Get( ))) ==
+             SearchState::SUCCEEDED )
+        {
+            cout << "\nPath with (14, 10) closed in version " << edited->GetVersion( ) << ": "
+                 << detour.GetSizePath( ) << " nodes, version " << snapshot->GetVersion( )
+                 << " still reads " << snapshot->GetCell( 14, 10 ) << " there\n";
+
+            detour.FreeSolutionNodes( );
+        }
+    }
+
     // Display the number of loops the search went through
     // cout << "SearchSteps : " << SearchSteps << "\n";
 
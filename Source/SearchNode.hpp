@@ -0,0 +1,204 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// STL A* Search implementation
+// (C)2001 Justin Heyes-Jones
+//
+// The user state of the grid maze shared by the example programs
+// Each node reads the map snapshot it was created with, so searches running
+// at the same time as map edits each see one consistent map
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SEARCH_NODE_HPP
+#define SEARCH_NODE_HPP
+
+#include "AStar.hpp" // See header for copyright and usage information
+#include "GridMap.hpp"
+
+#include <iostream>
+#include <cmath>
+#include <iomanip>
+
+// Definitions
+
+class SearchNode
+{
+
+public:
+
+	int x;	 // the (x,y) positions of the node
+	int y;	
+
+	const GridMap::Snapshot *map; // the map searched
+	
+	SearchNode() { x = y = 0; map = nullptr; }
+	SearchNode( int px, int py, const GridMap::Snapshot *pmap ) { x=px; y=py; map=pmap; }
+
+	float GoalDistanceEstimate( SearchNode &nodeGoal );
+	bool IsGoal( SearchNode &nodeGoal );
+
+    template <class Search> bool GetSuccessors( Search *nAStar, SearchNode *nParentNode );
+	float GetCost( SearchNode &successor );
+	bool IsSameState( SearchNode &rhs );
+
+	// Used by the parallel search to pick the thread owning the node
+	size_t Hash();
+
+	// Used by the any angle search
+	bool LineOfSight( SearchNode &target );
+	float GetDistance( SearchNode &target );
+
+	void PrintNodeInfo(); 
+
+
+};
+
+inline bool SearchNode::IsSameState( SearchNode &rhs )
+{
+	// same state in a maze search is simply when (x,y) are the same
+    return ( x == rhs.x ) && ( y == rhs.y );
+}
+
+inline size_t SearchNode::Hash()
+{
+    return ( size_t ) (( unsigned int ) y << 16 ) ^ ( unsigned int ) x;
+}
+
+inline void SearchNode::PrintNodeInfo()
+{
+	cout << "Node position : (" << setw(2) << x << ", " << setw(2) << y << ")\n";
+}
+
+// Here's the heuristic function that estimates the distance from a Node
+// to the Goal. The distance is estimate with Manhattan distance.
+inline float SearchNode::GoalDistanceEstimate( SearchNode &nodeGoal )
+{
+	return abs(x - nodeGoal.x) + abs(y - nodeGoal.y);
+}
+
+inline bool SearchNode::IsGoal( SearchNode &nodeGoal )
+{
+    return ( x == nodeGoal.x ) && ( y == nodeGoal.y );
+}
+
+// This generates the successors to the given Node. It uses a helper function called
+// AddSuccessor to give the successors to the AStar class. The A* specific initialisation
+// is done for each node internally, so here you just set the state information that
+// is specific to the application. Any search class with an AddSuccessor function
+// can be used, such as AStar in grid or in any angle mode
+template <class Search> bool SearchNode::GetSuccessors( Search *nAStar, SearchNode *nParentNode )
+{
+
+	int parentX = -1;
+	int parentY = -1;
+
+    if ( nParentNode )
+    {
+        parentX = nParentNode->x;
+        parentY = nParentNode->y;
+	}
+	
+
+	SearchNode NewNode;
+
+	// push each possible move except allowing the search to go backwards
+
+    if (( map->GetCell( x - 1, y ) < 9 ) && !( parentX == x - 1 && parentY == y ))
+	{
+		NewNode = SearchNode( x - 1, y, map );
+        nAStar->AddSuccessor( NewNode );
+	}
+
+    if (( map->GetCell( x + 1, y ) < 9 ) && !( parentX == x + 1 && parentY == y ))
+    {
+        NewNode = SearchNode( x + 1, y, map );
+        nAStar->AddSuccessor( NewNode );
+    }
+
+    if (( map->GetCell( x, y - 1 ) < 9 ) && !( parentX == x && parentY == y - 1 ))
+	{
+        NewNode = SearchNode( x, y - 1, map );
+        nAStar->AddSuccessor( NewNode );
+    }
+
+    if (( map->GetCell( x, y + 1 ) < 9 ) && !( parentX == x && parentY == y + 1 ))
+	{
+		NewNode = SearchNode( x, y + 1, map );
+        nAStar->AddSuccessor( NewNode );
+	}	
+
+	return true;
+}
+
+// given this node, what does it cost to move to successor. In the case
+// of our map the answer is the map terrain value at this node since that is 
+// conceptually where we're moving
+inline float SearchNode::GetCost( SearchNode &successor )
+{
+    return ( float ) map->GetCell( successor.x, successor.y );
+}
+
+// The straight segment between the centres of both cells can be walked if
+// every cell it crosses can be walked. Where the segment goes exactly
+// through the corner of a cell both cells beside the corner must be free,
+// so the segment never squeezes between two diagonal walls.
+inline bool SearchNode::LineOfSight( SearchNode &target )
+{
+    int dx = abs( target.x - x );
+    int dy = abs( target.y - y );
+    int stepX = ( target.x > x ) ? 1 : -1;
+    int stepY = ( target.y > y ) ? 1 : -1;
+
+    int cellX = x;
+    int cellY = y;
+
+    // Twice the signed distance to the next vertical against horizontal cell edge
+    int error = dx - dy;
+
+    dx *= 2;
+    dy *= 2;
+
+    while ( cellX != target.x || cellY != target.y )
+    {
+        if ( error > 0 )
+        {
+            cellX += stepX;
+            error -= dy;
+        }
+        else if ( error < 0 )
+        {
+            cellY += stepY;
+            error += dx;
+        }
+        else
+        {
+            if (( map->GetCell( cellX + stepX, cellY ) >= 9 ) || ( map->GetCell( cellX, cellY + stepY ) >= 9 ))
+            {
+                return false;
+            }
+
+            cellX += stepX;
+            cellY += stepY;
+            error += dx - dy;
+        }
+
+        if ( map->GetCell( cellX, cellY ) >= 9 )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Length of the straight segment, the walkable cells of the maps used by
+// the examples all cost the same so it is also its cost
+inline float SearchNode::GetDistance( SearchNode &target )
+{
+    float dx = ( float ) ( target.x - x );
+    float dy = ( float ) ( target.y - y );
+
+    return sqrt(( dx * dx ) + ( dy * dy ));
+}
+
+#endif
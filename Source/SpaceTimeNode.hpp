@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// STL A* Search implementation
+// (C)2001 Justin Heyes-Jones
+//
+// The space-time user state of cooperative path finding
+// Each node carries the agent it plans for, the reservation table and the map
+// snapshot, so several agents can be planned at the same time on other threads
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SPACE_TIME_NODE_HPP
+#define SPACE_TIME_NODE_HPP
+
+#include "AStar.hpp" // See header for copyright and usage information
+#include "GridMap.hpp"
+#include "ReservationTable.hpp"
+
+#include <cmath>
+
+// Last time step an agent may plan to, the search gives up after it
+constexpr int TIME_HORIZON = 100;
+
+// Definitions
+
+class SpaceTimeNode
+{
+
+public:
+
+	int x;	 // the (x,y) positions of the node
+	int y;
+	int t;	 // the time step the agent is at (x,y)
+
+	int agent; // the agent planned, its own reservations never block it
+
+	const ReservationTable *reservations; // cells reserved by the agents already planned
+	const GridMap::Snapshot *map; // the map searched
+
+	SpaceTimeNode() { x = y = t = agent = 0; reservations = nullptr; map = nullptr; }
+	SpaceTimeNode( int px, int py, int pt, int pagent, const ReservationTable *preservations,
+	               const GridMap::Snapshot *pmap )
+	{ x=px; y=py; t=pt; agent=pagent; reservations=preservations; map=pmap; }
+
+	float GoalDistanceEstimate( SpaceTimeNode &nodeGoal );
+	bool IsGoal( SpaceTimeNode &nodeGoal );
+
+    template <class Search> bool GetSuccessors( Search *nAStar, SpaceTimeNode *nParentNode );
+	float GetCost( SpaceTimeNode &successor );
+	bool IsSameState( SpaceTimeNode &rhs );
+
+	// Lets AStar find the states it has seen through a hash index
+	size_t Hash();
+};
+
+inline bool SpaceTimeNode::IsSameState( SpaceTimeNode &rhs )
+{
+	// the same cell at a different time is a different state
+    return ( x == rhs.x ) && ( y == rhs.y ) && ( t == rhs.t );
+}
+
+inline size_t SpaceTimeNode::Hash()
+{
+    return ( size_t ) ((( std::uint64_t ) ( unsigned int ) t << 32 ) ^ (( std::uint64_t ) ( unsigned int ) y << 16 ) ^
+                       ( unsigned int ) x );
+}
+
+// Manhattan distance, time is not part of the estimate since waiting
+// never brings the agent closer to the goal
+inline float SpaceTimeNode::GoalDistanceEstimate( SpaceTimeNode &nodeGoal )
+{
+	return abs(x - nodeGoal.x) + abs(y - nodeGoal.y);
+}
+
+// The goal is only reached if the agent can stay there, otherwise an agent
+// with a higher priority would run into it later on
+inline bool SpaceTimeNode::IsGoal( SpaceTimeNode &nodeGoal )
+{
+    return ( x == nodeGoal.x ) && ( y == nodeGoal.y ) &&
+           reservations->IsFreeFrom( agent, x, y, t, TIME_HORIZON );
+}
+
+// The successors are the four moves plus waiting in place, each one step
+// later in time and only when the reservation table allows it
+template <class Search> bool SpaceTimeNode::GetSuccessors( Search *nAStar, SpaceTimeNode * )
+{
+    if ( t >= TIME_HORIZON )
+    {
+        return true;
+    }
+
+    const int moves[5][2] = {{ 0, 0 }, { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 }};
+
+    for ( const auto &move : moves )
+    {
+        int newX = x + move[0];
+        int newY = y + move[1];
+
+        if (( map->GetCell( newX, newY ) < 9 ) &&
+            reservations->IsMoveFree( agent, x, y, newX, newY, t ))
+        {
+            SpaceTimeNode NewNode( newX, newY, t + 1, agent, reservations, map );
+            nAStar->AddSuccessor( NewNode );
+        }
+    }
+
+	return true;
+}
+
+// Moving costs the terrain value of the destination, waiting costs one step
+inline float SpaceTimeNode::GetCost( SpaceTimeNode &successor )
+{
+    if ( successor.x == x && successor.y == y )
+    {
+        return 1.0f;
+    }
+
+    return ( float ) map->GetCell( successor.x, successor.y );
+}
+
+#endif
@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// STL A* Search implementation
+// (C)2001 Justin Heyes-Jones
+//
+// Renders the expansions of a recorded search over the simple grid maze
+// Usage: TraceHeatmap <trace file>, the trace is written by FindPath when it
+// is built with ASTAR_TRACE
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "SearchTrace.hpp"
+#include "WorldMap.hpp"
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// Main
+
+int main( int argc, char *argv[] )
+{
+    if ( argc < 2 )
+    {
+        cout << "Usage: " << argv[0] << " <trace file>\n";
+        return 1;
+    }
+
+    vector <TraceRecord> records;
+
+    if ( !SearchTrace::ReadBinary( argv[1], records ))
+    {
+        cout << "Could not read the trace " << argv[1] << "\n";
+        return 1;
+    }
+
+    // Count the events of each cell
+
+    vector <int> pops( MAP_WIDTH * MAP_HEIGHT, 0 );
+    int counts[5] = { 0, 0, 0, 0, 0 };
+    int outside = 0;
+
+    for ( const TraceRecord &record : records )
+    {
+        counts[( int ) record.event] += 1;
+
+        if ( record.x < 0 || record.x >= MAP_WIDTH || record.y < 0 || record.y >= MAP_HEIGHT )
+        {
+            outside += 1;
+            continue;
+        }
+
+        if ( record.event == TraceEvent::POP )
+        {
+            pops[( record.y * MAP_WIDTH ) + record.x] += 1;
+        }
+    }
+
+    // Same layout as Documentation/Map.md, expanded cells show the number of
+    // times they were expanded, a '+' meaning more than nine
+
+    cout << "\n### Expansions\n\n";
+
+    for ( int y = 0; y < MAP_HEIGHT; y++ )
+    {
+        cout << "\t";
+
+        for ( int x = 0; x < MAP_WIDTH; x++ )
+        {
+            int count = pops[( y * MAP_WIDTH ) + x];
+            char cell;
+
+            if ( GetMap( x, y ) >= 9 )
+            {
+                cell = '#';
+            }
+            else if ( count == 0 )
+            {
+                cell = '.';
+            }
+            else if ( count > 9 )
+            {
+                cell = '+';
+            }
+            else
+            {
+                cell = ( char ) ( '0' + count );
+            }
+
+            cout << cell << ( x < MAP_WIDTH - 1 ? " " : "\n" );
+        }
+    }
+
+    cout << "\nWhere: '.' is walkable, '#' is no-walkable and a digit is the number of expansions\n\n";
+    cout << "Events: " << records.size( ) << "\n";
+    cout << "- pop    " << counts[( int ) TraceEvent::POP] << "\n";
+    cout << "- push   " << counts[( int ) TraceEvent::PUSH] << "\n";
+    cout << "- update " << counts[( int ) TraceEvent::UPDATE] << "\n";
+    cout << "- reopen " << counts[( int ) TraceEvent::REOPEN] << "\n";
+    cout << "- prune  " << counts[( int ) TraceEvent::PRUNE] << "\n";
+
+    if ( outside > 0 )
+    {
+        cout << "Events outside of the map: " << outside << "\n";
+    }
+
+    if ( !records.empty( ))
+    {
+        cout << "Duration: " << ( records.back( ).time - records.front( ).time ) / 1000 << " microseconds\n";
+    }
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////